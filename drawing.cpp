@@ -4,6 +4,10 @@ DrawableState Drawable::getState() {
     return state;
 }
 
+DrawableKind Drawable::kind() {
+    return OtherK;
+}
+
 Drawable::~Drawable() {
     //no particular destructor behavior needed.
     //virtual destructor defined to support polymorphism in destructors
@@ -13,3 +17,7 @@ void Drawable::resetState() {
     state = NormalS;
 }
 
+
+void Drawable::expire() {
+    state = ExpiredS;
+}
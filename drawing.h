@@ -9,6 +9,24 @@ enum DrawableState {
     ActiveS
 };
 
+//identifiers for the kind of object a drawable is
+//lets the registry be sorted without a dynamic_cast per object
+enum DrawableKind {
+    OtherK,
+    NodeK,
+    EdgeK
+};
+
+//cached appearance of a drawable, computed from style rules by styles.h
+//size is the radius of a node, or the line width of an edge
+struct Style {
+    float color[3] = {0, 0, 0};
+    float size = 1;
+    //generation of the style rules, and version of the traits, this was computed from
+    unsigned generation = 0;
+    unsigned version = 0;
+};
+
 //Interface representing a drawable, potentially-clickable object
 class Drawable {
     public:
@@ -18,10 +36,14 @@ class Drawable {
         //function to draw an object
         virtual void draw() = 0;
         DrawableState getState();
+        //identify what kind of object this is -- OtherK unless overridden
+        virtual DrawableKind kind();
         //make virtual destructor -- enable polymorphism for destructors in implementation classes
         virtual ~Drawable();
         //reset to normal state
         void resetState();
+        //mark for deletion by the owner of the registry
+        void expire();
     private:
     protected:
         DrawableState state;
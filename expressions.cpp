@@ -0,0 +1,787 @@
+#include "expressions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+//kinds of token in the expression language
+enum TokenKind {
+    NumberTok,
+    StringTok,
+    NameTok,
+    SymbolTok,
+    EndTok
+};
+
+struct Token {
+    TokenKind kind;
+    string text;
+    //column the token starts at, for error messages
+    int column;
+};
+
+//split a statement into tokens
+//returns nonzero iff error, with a message in error
+static int tokenize(const string &source, std::vector<Token> &tokens, string &error) {
+    static const char *pairs[] = {"==", "!=", "<=", ">=", "&&", "||"};
+    int i = 0;
+    while(i < source.size()) {
+        char c = source[i];
+        int start = i;
+        if(isspace((unsigned char)c)) {
+            i++;
+            continue;
+        }
+        if(isdigit((unsigned char)c) || (c == '.' && i + 1 < source.size() && isdigit((unsigned char)source[i + 1]))) {
+            while(i < source.size() && (isalnum((unsigned char)source[i]) || source[i] == '.' ||
+                  ((source[i] == '-' || source[i] == '+') && (source[i - 1] == 'e' || source[i - 1] == 'E')))) {
+                i++;
+            }
+            tokens.push_back({NumberTok, source.substr(start, i - start), start});
+        } else if(isalpha((unsigned char)c) || c == '_') {
+            while(i < source.size() && (isalnum((unsigned char)source[i]) || source[i] == '_')) {
+                i++;
+            }
+            tokens.push_back({NameTok, source.substr(start, i - start), start});
+        } else if(c == '{') {
+            //any label at all, up to the closing brace
+            size_t close = source.find('}', i);
+            if(close == string::npos) {
+                error = "Unclosed '{' at column " + std::to_string(start + 1) + ".";
+                return 1;
+            }
+            tokens.push_back({NameTok, source.substr(i + 1, close - i - 1), start});
+            i = close + 1;
+        } else if(c == '"') {
+            string text;
+            i++;
+            while(i < source.size() && source[i] != '"') {
+                if(source[i] == '\\' && i + 1 < source.size()) {
+                    i++;
+                }
+                text += source[i++];
+            }
+            if(i >= source.size()) {
+                error = "Unclosed string at column " + std::to_string(start + 1) + ".";
+                return 1;
+            }
+            i++;
+            tokens.push_back({StringTok, text, start});
+        } else {
+            string symbol(1, c);
+            for(int p = 0; p < 6; p++) {
+                if(source.compare(i, 2, pairs[p]) == 0) {
+                    symbol = pairs[p];
+                }
+            }
+            if(symbol.size() == 1 && !strchr("=<>+-*/()!", c)) {
+                error = string("Unexpected '") + c + "' at column " + std::to_string(start + 1) + ".";
+                return 1;
+            }
+            i += symbol.size();
+            tokens.push_back({SymbolTok, symbol, start});
+        }
+    }
+    tokens.push_back({EndTok, "", (int)source.size()});
+    return 0;
+}
+
+static const char *typeName(ValueType type) {
+    switch(type) {
+        case IntV:
+            return "an int";
+        case DoubleV:
+            return "a double";
+        case StringV:
+            return "a string";
+        default:
+            return "true or false";
+    }
+}
+
+//value type of a trait type -- NoneT has none, and gives BoolV
+static ValueType valueType(TraitType type) {
+    switch(type) {
+        case IntT:
+            return IntV;
+        case DoubleT:
+            return DoubleV;
+        case StringT:
+            return StringV;
+        default:
+            return BoolV;
+    }
+}
+
+//collect the trait frames of every live node or edge -- owners, if given, gets the object of each frame
+static void gatherFrames(const std::vector<Drawable *> &graph, DrawableKind kind,
+                         std::vector<TraitFrame *> &frames, std::vector<Drawable *> *owners) {
+    for(int i = 0; i < graph.size(); i++) {
+        if(graph[i]->kind() != kind || graph[i]->getState() == ExpiredS) {
+            continue;
+        }
+        if(kind == NodeK) {
+            frames.push_back(&static_cast<GraphNode *>(graph[i])->traits);
+            if(owners) {
+                owners->push_back(graph[i]);
+            }
+        } else {
+            GraphEdge *e = static_cast<GraphEdge *>(graph[i]);
+            frames.push_back(&e->traits);
+            for(int r = 0; r < e->rows.size(); r++) {
+                frames.push_back(&e->rows[r]);
+            }
+            if(owners) {
+                owners->insert(owners->end(), e->count(), e);
+            }
+        }
+    }
+}
+
+//type of the first trait with a label, in any frame
+static TraitType findTrait(const std::vector<TraitFrame *> &frames, const string &label) {
+    const void *p;
+    for(int i = 0; i < frames.size(); i++) {
+        TraitType type = frames[i]->get(label, &p);
+        if(type != NoneT) {
+            return type;
+        }
+    }
+    return NoneT;
+}
+
+//recursive-descent parser, which emits steps as it goes
+//each parse function returns false on error, with a message in error
+class Parser {
+    public:
+        Parser(const std::vector<Token> &inTokens, const std::vector<TraitFrame *> &inFrames,
+               DrawableKind inKind, ExprProgram &inProgram)
+            : tokens(inTokens), frames(inFrames), kind(inKind), program(inProgram) {
+            next = 0;
+        }
+
+        bool statement() {
+            Operand value;
+            if(tokens.size() > 2 && tokens[0].kind == NameTok && tokens[1].kind == SymbolTok && tokens[1].text == "=") {
+                program.target = tokens[0].text;
+                next = 2;
+                if(!orExpr(&value)) {
+                    return false;
+                }
+                //a trait keeps its type -- rows holding it with another type are counted and skipped
+                ValueType stored = (value.type == BoolV) ? IntV : value.type;
+                TraitType existing = findTrait(frames, program.target);
+                if(existing != NoneT && valueType(existing) != stored) {
+                    return fail(tokens[0], "\"" + program.target + "\" holds " + typeName(valueType(existing)) +
+                                ", but is assigned " + typeName(stored) + ".");
+                }
+            } else {
+                if(!orExpr(&value)) {
+                    return false;
+                }
+                if(value.type != BoolV) {
+                    return fail(tokens[0], string("A condition must be true or false, not ") +
+                                typeName(value.type) + ".");
+                }
+            }
+            if(tokens[next].kind != EndTok) {
+                return fail(tokens[next], "Unexpected \"" + tokens[next].text + "\".");
+            }
+            program.result = value.reg;
+            return true;
+        }
+
+        string error;
+
+    private:
+        struct Operand {
+            int reg;
+            ValueType type;
+        };
+
+        bool fail(const Token &at, string message) {
+            error = message + " (column " + std::to_string(at.column + 1) + ")";
+            return false;
+        }
+
+        bool accept(const char *symbol) {
+            if(tokens[next].kind == SymbolTok && tokens[next].text == symbol) {
+                next++;
+                return true;
+            }
+            return false;
+        }
+
+        //append a step, returning a new register of type result for it to write
+        int emit(ExprStep::Op op, ValueType type, ValueType result, int a, int b, int arg) {
+            program.registers.push_back(result);
+            int dst = program.registers.size() - 1;
+            program.steps.push_back({op, type, dst, a, b, arg});
+            return dst;
+        }
+
+        void toDouble(Operand *x) {
+            if(x->type == IntV) {
+                x->reg = emit(ExprStep::ToDoubleS, IntV, DoubleV, x->reg, -1, 0);
+                x->type = DoubleV;
+            }
+        }
+
+        bool numeric(const Operand &x) {
+            return x.type == IntV || x.type == DoubleV;
+        }
+
+        bool orExpr(Operand *out) {
+            if(!andExpr(out)) {
+                return false;
+            }
+            while(tokens[next].text == "||" && tokens[next].kind == SymbolTok) {
+                if(!logical(out, ExprStep::OrS, &Parser::andExpr)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool andExpr(Operand *out) {
+            if(!compareExpr(out)) {
+                return false;
+            }
+            while(tokens[next].text == "&&" && tokens[next].kind == SymbolTok) {
+                if(!logical(out, ExprStep::AndS, &Parser::compareExpr)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //combine out with the operand after the current operator, both of which must be conditions
+        bool logical(Operand *out, ExprStep::Op op, bool (Parser::*operand)(Operand *)) {
+            const Token &at = tokens[next++];
+            Operand right;
+            if(!(this->*operand)(&right)) {
+                return false;
+            }
+            if(out->type != BoolV || right.type != BoolV) {
+                return fail(at, "\"" + at.text + "\" joins conditions, not values.");
+            }
+            out->reg = emit(op, BoolV, BoolV, out->reg, right.reg, 0);
+            return true;
+        }
+
+        bool compareExpr(Operand *out) {
+            static const char *symbols[] = {"==", "!=", "<", "<=", ">", ">="};
+            static const ExprStep::Op ops[] = {ExprStep::EqS, ExprStep::NeS, ExprStep::LtS,
+                                               ExprStep::LeS, ExprStep::GtS, ExprStep::GeS};
+            if(!sumExpr(out)) {
+                return false;
+            }
+            for(int i = 0; i < 6; i++) {
+                if(tokens[next].kind != SymbolTok || tokens[next].text != symbols[i]) {
+                    continue;
+                }
+                const Token &at = tokens[next++];
+                Operand right;
+                if(!sumExpr(&right)) {
+                    return false;
+                }
+                if(numeric(*out) && numeric(right)) {
+                    if(out->type != right.type) {
+                        toDouble(out);
+                        toDouble(&right);
+                    }
+                } else if(out->type != right.type) {
+                    return fail(at, string("Cannot compare ") + typeName(out->type) + " with " +
+                                typeName(right.type) + ".");
+                } else if(out->type == BoolV && i > 1) {
+                    return fail(at, "Conditions can only be compared with == and !=.");
+                }
+                out->reg = emit(ops[i], out->type, BoolV, out->reg, right.reg, 0);
+                out->type = BoolV;
+                return true;
+            }
+            return true;
+        }
+
+        bool sumExpr(Operand *out) {
+            if(!termExpr(out)) {
+                return false;
+            }
+            while(tokens[next].kind == SymbolTok && (tokens[next].text == "+" || tokens[next].text == "-")) {
+                if(!arithmetic(out, (tokens[next].text == "+") ? ExprStep::AddS : ExprStep::SubS,
+                               &Parser::termExpr)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool termExpr(Operand *out) {
+            if(!unaryExpr(out)) {
+                return false;
+            }
+            while(tokens[next].kind == SymbolTok && (tokens[next].text == "*" || tokens[next].text == "/")) {
+                if(!arithmetic(out, (tokens[next].text == "*") ? ExprStep::MulS : ExprStep::DivS,
+                               &Parser::unaryExpr)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //combine out with the operand after the current operator, both of which must be numbers
+        bool arithmetic(Operand *out, ExprStep::Op op, bool (Parser::*operand)(Operand *)) {
+            const Token &at = tokens[next++];
+            Operand right;
+            if(!(this->*operand)(&right)) {
+                return false;
+            }
+            if(!numeric(*out) || !numeric(right)) {
+                return fail(at, "\"" + at.text + "\" needs numbers, not " +
+                            typeName(numeric(*out) ? right.type : out->type) + ".");
+            }
+            //division always gives a double, so  Population / area  is never truncated
+            if(op == ExprStep::DivS || out->type != right.type) {
+                toDouble(out);
+                toDouble(&right);
+            }
+            out->reg = emit(op, out->type, out->type, out->reg, right.reg, 0);
+            return true;
+        }
+
+        bool unaryExpr(Operand *out) {
+            const Token &at = tokens[next];
+            if(accept("-")) {
+                if(!unaryExpr(out)) {
+                    return false;
+                }
+                if(!numeric(*out)) {
+                    return fail(at, string("Cannot negate ") + typeName(out->type) + ".");
+                }
+                out->reg = emit(ExprStep::NegS, out->type, out->type, out->reg, -1, 0);
+                return true;
+            }
+            if(accept("!")) {
+                if(!unaryExpr(out)) {
+                    return false;
+                }
+                if(out->type != BoolV) {
+                    return fail(at, string("Cannot apply \"!\" to ") + typeName(out->type) + ".");
+                }
+                out->reg = emit(ExprStep::NotS, BoolV, BoolV, out->reg, -1, 0);
+                return true;
+            }
+            return primary(out);
+        }
+
+        bool primary(Operand *out) {
+            const Token &at = tokens[next];
+            if(accept("(")) {
+                if(!orExpr(out)) {
+                    return false;
+                }
+                if(!accept(")")) {
+                    return fail(tokens[next], "Expected \")\".");
+                }
+                return true;
+            }
+            next++;
+            if(at.kind == NumberTok) {
+                char *end;
+                if(at.text.find_first_of(".eE") == string::npos) {
+                    program.intConstants.push_back(strtoll(at.text.c_str(), &end, 10));
+                    out->type = IntV;
+                    out->reg = emit(ExprStep::ConstS, IntV, IntV, -1, -1, program.intConstants.size() - 1);
+                } else {
+                    program.doubleConstants.push_back(strtod(at.text.c_str(), &end));
+                    out->type = DoubleV;
+                    out->reg = emit(ExprStep::ConstS, DoubleV, DoubleV, -1, -1, program.doubleConstants.size() - 1);
+                }
+                if(*end) {
+                    return fail(at, "Malformed number \"" + at.text + "\".");
+                }
+                return true;
+            }
+            if(at.kind == StringTok) {
+                program.stringConstants.push_back(at.text);
+                out->type = StringV;
+                out->reg = emit(ExprStep::ConstS, StringV, StringV, -1, -1, program.stringConstants.size() - 1);
+                return true;
+            }
+            if(at.kind == NameTok) {
+                return trait(at, out);
+            }
+            return fail(at, (at.kind == EndTok) ? string("Unexpected end of expression.") :
+                            "Unexpected \"" + at.text + "\".");
+        }
+
+        //read a trait, with the type of the first node or edge which has it
+        //each trait is looked up once per row, however often the statement names it
+        bool trait(const Token &at, Operand *out) {
+            int index = -1;
+            for(int i = 0; i < program.traits.size(); i++) {
+                if(program.traits[i] == at.text) {
+                    index = i;
+                }
+            }
+            if(index < 0) {
+                TraitType type = findTrait(frames, at.text);
+                if(type == NoneT) {
+                    return fail(at, string("No ") + ((kind == NodeK) ? "node" : "edge") +
+                                " has a trait \"" + at.text + "\".");
+                }
+                program.traits.push_back(at.text);
+                program.traitTypes.push_back(valueType(type));
+                program.traitLoads.push_back(-1);
+                index = program.traits.size() - 1;
+            }
+            out->type = program.traitTypes[index];
+            if(program.traitLoads[index] < 0) {
+                program.traitLoads[index] = emit(ExprStep::LoadS, out->type, out->type, -1, -1, index);
+            }
+            out->reg = program.traitLoads[index];
+            return true;
+        }
+
+        const std::vector<Token> &tokens;
+        const std::vector<TraitFrame *> &frames;
+        DrawableKind kind;
+        ExprProgram &program;
+        int next;
+};
+
+
+Expression::Expression() {
+    kind = NodeK;
+    program.result = -1;
+}
+
+int Expression::compile(string inSource, const std::vector<Drawable *> &graph, DrawableKind inKind) {
+    source = inSource;
+    kind = inKind;
+    program = ExprProgram();
+    program.result = -1;
+
+    std::vector<Token> tokens;
+    string error;
+    if(tokenize(source, tokens, error)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Expression \"%s\": %s", source.c_str(), error.c_str());
+        return 1;
+    }
+    std::vector<TraitFrame *> frames;
+    gatherFrames(graph, kind, frames, NULL);
+    Parser parser(tokens, frames, kind, program);
+    if(!parser.statement()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Expression \"%s\": %s", source.c_str(), parser.error.c_str());
+        program.result = -1;
+        return 1;
+    }
+    return 0;
+}
+
+bool Expression::isAssignment() {
+    return program.target != "";
+}
+
+long long Expression::run(const std::vector<Drawable *> &graph, std::vector<Drawable *> *matches) {
+    if(program.result < 0) {
+        return 0;
+    }
+    std::vector<TraitFrame *> frames;
+    std::vector<Drawable *> owners;
+    gatherFrames(graph, kind, frames, matches ? &owners : NULL);
+    std::vector<char> hit(isAssignment() ? 0 : frames.size(), 0);
+
+    std::atomic<long long> done(0);
+    std::atomic<long long> conflicts(0);
+    auto work = [&](int start, int end) {
+        //each thread has its own registers, sized for one block
+        std::vector<ExprRegister> regs(program.registers.size());
+        for(int i = 0; i < regs.size(); i++) {
+            regs[i].valid.resize(EXPR_BLOCK);
+            switch(program.registers[i]) {
+                case DoubleV:
+                    regs[i].doubles.resize(EXPR_BLOCK);
+                    break;
+                case StringV:
+                    regs[i].strings.resize(EXPR_BLOCK);
+                    break;
+                default:
+                    regs[i].ints.resize(EXPR_BLOCK);
+                    break;
+            }
+        }
+        long long blockDone = 0;
+        long long blockConflicts = 0;
+        for(int i = start; i < end; i += EXPR_BLOCK) {
+            runBlock(frames, i, std::min(end, i + EXPR_BLOCK), regs, hit, &blockDone, &blockConflicts);
+        }
+        done += blockDone;
+        conflicts += blockConflicts;
+    };
+
+    int threadCount = std::min((int)std::thread::hardware_concurrency(), (int)(frames.size() / EXPR_CHUNK));
+    if(threadCount < 2) {
+        work(0, frames.size());
+    } else {
+        std::vector<std::thread> threads;
+        int step = (frames.size() + threadCount - 1) / threadCount;
+        for(int i = 0; i < threadCount; i++) {
+            threads.push_back(std::thread(work, i * step, std::min((int)frames.size(), (i + 1) * step)));
+        }
+        for(int i = 0; i < threads.size(); i++) {
+            threads[i].join();
+        }
+    }
+
+    if(conflicts) {
+        SDL_Log("Expression \"%s\": %lld rows hold \"%s\" with another type, and were left unchanged.",
+                source.c_str(), (long long)conflicts, program.target.c_str());
+    }
+    if(matches && !isAssignment()) {
+        //a bundled edge matches once, however many of its rows do
+        Drawable *last = NULL;
+        for(int i = 0; i < hit.size(); i++) {
+            if(hit[i] && owners[i] != last) {
+                matches->push_back(owners[i]);
+                last = owners[i];
+            }
+        }
+    }
+    return done;
+}
+
+//read a trait for a block of rows
+static void load(const std::vector<TraitFrame *> &frames, int start, int n, const string &label,
+                 ValueType type, ExprRegister &out) {
+    const void *p;
+    switch(type) {
+        case IntV:
+            for(int r = 0; r < n; r++) {
+                bool found = frames[start + r]->get(label, &p) == IntT;
+                out.valid[r] = found;
+                out.ints[r] = found ? *(const int *)p : 0;
+            }
+            break;
+        case DoubleV:
+            for(int r = 0; r < n; r++) {
+                TraitType found = frames[start + r]->get(label, &p);
+                out.valid[r] = (found == DoubleT || found == IntT);
+                out.doubles[r] = (found == DoubleT) ? *(const double *)p : (found == IntT) ? *(const int *)p : 0;
+            }
+            break;
+        default:
+            for(int r = 0; r < n; r++) {
+                bool found = frames[start + r]->get(label, &p) == StringT;
+                out.valid[r] = found;
+                out.strings[r] = found ? (const string *)p : NULL;
+            }
+            break;
+    }
+}
+
+//arithmetic over a block -- ints wrap on overflow, rather than being undefined
+static void arithmetic(ExprStep::Op op, const std::vector<long long> &a, const std::vector<long long> &b,
+                       std::vector<long long> &out, int n) {
+    typedef unsigned long long U;
+    switch(op) {
+        case ExprStep::AddS:
+            for(int r = 0; r < n; r++) { out[r] = (long long)((U)a[r] + (U)b[r]); }
+            break;
+        case ExprStep::SubS:
+            for(int r = 0; r < n; r++) { out[r] = (long long)((U)a[r] - (U)b[r]); }
+            break;
+        case ExprStep::MulS:
+            for(int r = 0; r < n; r++) { out[r] = (long long)((U)a[r] * (U)b[r]); }
+            break;
+        default:
+            for(int r = 0; r < n; r++) { out[r] = (long long)(0 - (U)a[r]); }
+            break;
+    }
+}
+
+static void arithmetic(ExprStep::Op op, const std::vector<double> &a, const std::vector<double> &b,
+                       std::vector<double> &out, int n) {
+    switch(op) {
+        case ExprStep::AddS:
+            for(int r = 0; r < n; r++) { out[r] = a[r] + b[r]; }
+            break;
+        case ExprStep::SubS:
+            for(int r = 0; r < n; r++) { out[r] = a[r] - b[r]; }
+            break;
+        case ExprStep::MulS:
+            for(int r = 0; r < n; r++) { out[r] = a[r] * b[r]; }
+            break;
+        case ExprStep::DivS:
+            for(int r = 0; r < n; r++) { out[r] = a[r] / b[r]; }
+            break;
+        default:
+            for(int r = 0; r < n; r++) { out[r] = -a[r]; }
+            break;
+    }
+}
+
+template <class T>
+static void compare(ExprStep::Op op, const std::vector<T> &a, const std::vector<T> &b,
+                    std::vector<long long> &out, int n) {
+    switch(op) {
+        case ExprStep::EqS:
+            for(int r = 0; r < n; r++) { out[r] = a[r] == b[r]; }
+            break;
+        case ExprStep::NeS:
+            for(int r = 0; r < n; r++) { out[r] = a[r] != b[r]; }
+            break;
+        case ExprStep::LtS:
+            for(int r = 0; r < n; r++) { out[r] = a[r] < b[r]; }
+            break;
+        case ExprStep::LeS:
+            for(int r = 0; r < n; r++) { out[r] = a[r] <= b[r]; }
+            break;
+        case ExprStep::GtS:
+            for(int r = 0; r < n; r++) { out[r] = a[r] > b[r]; }
+            break;
+        default:
+            for(int r = 0; r < n; r++) { out[r] = a[r] >= b[r]; }
+            break;
+    }
+}
+
+//whether a comparison holds, given the sign of the difference between its operands
+static bool holds(ExprStep::Op op, int order) {
+    switch(op) {
+        case ExprStep::EqS:
+            return order == 0;
+        case ExprStep::NeS:
+            return order != 0;
+        case ExprStep::LtS:
+            return order < 0;
+        case ExprStep::LeS:
+            return order <= 0;
+        case ExprStep::GtS:
+            return order > 0;
+        default:
+            return order >= 0;
+    }
+}
+
+void Expression::runBlock(const std::vector<TraitFrame *> &frames, int start, int end,
+                          std::vector<ExprRegister> &regs, std::vector<char> &hit,
+                          long long *done, long long *conflicts) {
+    int n = end - start;
+    for(int i = 0; i < program.steps.size(); i++) {
+        const ExprStep &s = program.steps[i];
+        ExprRegister &out = regs[s.dst];
+        //unary steps read a twice, so every step can treat b the same way
+        ExprRegister &a = regs[(s.a < 0) ? s.dst : s.a];
+        ExprRegister &b = regs[(s.b < 0) ? ((s.a < 0) ? s.dst : s.a) : s.b];
+        switch(s.op) {
+            case ExprStep::LoadS:
+                load(frames, start, n, program.traits[s.arg], s.type, out);
+                continue;
+            case ExprStep::ConstS:
+                for(int r = 0; r < n; r++) {
+                    out.valid[r] = 1;
+                }
+                if(s.type == IntV) {
+                    std::fill(out.ints.begin(), out.ints.begin() + n, program.intConstants[s.arg]);
+                } else if(s.type == DoubleV) {
+                    std::fill(out.doubles.begin(), out.doubles.begin() + n, program.doubleConstants[s.arg]);
+                } else {
+                    std::fill(out.strings.begin(), out.strings.begin() + n, &program.stringConstants[s.arg]);
+                }
+                continue;
+            case ExprStep::ToDoubleS:
+                for(int r = 0; r < n; r++) {
+                    out.doubles[r] = a.ints[r];
+                }
+                break;
+            case ExprStep::AddS:
+            case ExprStep::SubS:
+            case ExprStep::MulS:
+            case ExprStep::DivS:
+            case ExprStep::NegS:
+                if(s.type == IntV) {
+                    arithmetic(s.op, a.ints, b.ints, out.ints, n);
+                } else {
+                    arithmetic(s.op, a.doubles, b.doubles, out.doubles, n);
+                }
+                break;
+            case ExprStep::AndS:
+                //a side known to be false decides the result, even if the other has no value
+                for(int r = 0; r < n; r++) {
+                    bool aFalse = a.valid[r] && !a.ints[r];
+                    bool bFalse = b.valid[r] && !b.ints[r];
+                    out.ints[r] = !(aFalse || bFalse);
+                    out.valid[r] = aFalse || bFalse || (a.valid[r] && b.valid[r]);
+                }
+                continue;
+            case ExprStep::OrS:
+                //likewise a side known to be true
+                for(int r = 0; r < n; r++) {
+                    bool aTrue = a.valid[r] && a.ints[r];
+                    bool bTrue = b.valid[r] && b.ints[r];
+                    out.ints[r] = aTrue || bTrue;
+                    out.valid[r] = aTrue || bTrue || (a.valid[r] && b.valid[r]);
+                }
+                continue;
+            case ExprStep::NotS:
+                for(int r = 0; r < n; r++) {
+                    out.ints[r] = !a.ints[r];
+                }
+                break;
+            default:
+                if(s.type == DoubleV) {
+                    compare(s.op, a.doubles, b.doubles, out.ints, n);
+                } else if(s.type == StringV) {
+                    for(int r = 0; r < n; r++) {
+                        out.ints[r] = (a.strings[r] && b.strings[r]) && holds(s.op, a.strings[r]->compare(*b.strings[r]));
+                    }
+                } else {
+                    compare(s.op, a.ints, b.ints, out.ints, n);
+                }
+                break;
+        }
+        //anything computed from a row with no value has no value
+        for(int r = 0; r < n; r++) {
+            out.valid[r] = a.valid[r] & b.valid[r];
+        }
+    }
+
+    ExprRegister &value = regs[program.result];
+    if(!isAssignment()) {
+        for(int r = 0; r < n; r++) {
+            if(value.valid[r] && value.ints[r]) {
+                hit[start + r] = 1;
+                (*done)++;
+            }
+        }
+        return;
+    }
+
+    ValueType type = program.registers[program.result];
+    TraitType stored = (type == DoubleV) ? DoubleT : (type == StringV) ? StringT : IntT;
+    const void *p;
+    for(int r = 0; r < n; r++) {
+        if(!value.valid[r]) {
+            continue;
+        }
+        TraitFrame *f = frames[start + r];
+        TraitType existing = f->get(program.target, &p);
+        if(existing != NoneT && existing != stored) {
+            (*conflicts)++;
+            continue;
+        }
+        if(stored == IntT) {
+            f->addInt(program.target, (int)value.ints[r]);
+        } else if(stored == DoubleT) {
+            f->addDouble(program.target, value.doubles[r]);
+        } else {
+            f->addString(program.target, *value.strings[r]);
+        }
+        (*done)++;
+    }
+}
@@ -0,0 +1,107 @@
+//defines a small language for computing traits in bulk, and for testing nodes or edges against a condition
+#ifndef EXPRESSIONS_H
+#define EXPRESSIONS_H
+
+#include "graphs.h"
+
+//rows run together through each instruction, and most rows given to one thread at a time
+#define EXPR_BLOCK (1024)
+#define EXPR_CHUNK (65536)
+
+//types of the values an expression works with -- traits' types, plus the results of conditions
+enum ValueType {
+    IntV,
+    DoubleV,
+    StringV,
+    BoolV
+};
+
+//one step of a compiled expression
+//each step reads registers a and b, and writes register dst, for a whole block of rows at once
+struct ExprStep {
+    //identifiers for what a step does
+    enum Op {
+        LoadS, ConstS, ToDoubleS,
+        AddS, SubS, MulS, DivS, NegS,
+        EqS, NeS, LtS, LeS, GtS, GeS,
+        AndS, OrS, NotS
+    };
+    Op op;
+    //type of the operands, which may differ from the type of dst for comparisons
+    ValueType type;
+    int dst, a, b;
+    //index of the trait for LoadS, or of the constant for ConstS
+    int arg;
+};
+
+//everything a statement compiles to
+struct ExprProgram {
+    std::vector<ExprStep> steps;
+    //type of each register
+    std::vector<ValueType> registers;
+    //register holding the statement's value
+    int result;
+
+    //labels of the traits read, with the type each was read as
+    std::vector<string> traits;
+    std::vector<ValueType> traitTypes;
+    //register each trait is loaded into
+    std::vector<int> traitLoads;
+    //constants, in one list for each type
+    std::vector<long long> intConstants;
+    std::vector<double> doubleConstants;
+    std::vector<string> stringConstants;
+
+    //trait assigned to, or "" for a condition
+    string target;
+};
+
+//values of one register for a block of rows -- only the list for the register's type is used
+struct ExprRegister {
+    //also holds bools
+    std::vector<long long> ints;
+    std::vector<double> doubles;
+    std::vector<const string *> strings;
+    //whether each row has a value
+    std::vector<char> valid;
+};
+
+//a statement, compiled once and then run over every node or edge of a graph
+//statements are either an assignment to a trait, e.g.  density = Population / area
+//or a condition, e.g.  State == "Idaho" && Population > 10000
+//trait labels which are not plain identifiers may be written in braces, e.g.  {times clicked}
+//a row missing a trait, or holding it with another type, has no value for it
+//an int read where a double is expected is converted
+//anything computed from no value has no value -- such rows are never assigned to, and never match
+//the exceptions are && and ||, when the side which has a value decides the result alone
+//division always gives a double
+class Expression {
+    public:
+        Expression();
+
+        //parse and type-check a statement, for the nodes or the edges of a graph
+        //each trait's type is taken from the first node or edge which has it
+        //returns nonzero iff error, which is logged
+        int compile(string source, const std::vector<Drawable *> &graph, DrawableKind kind);
+
+        //run the statement on every live node or edge, in parallel for large graphs
+        //bundled edges run it once for each of their trait rows
+        //every object a condition held for is appended to matches, if given
+        //returns the number of rows assigned to, or matched
+        long long run(const std::vector<Drawable *> &graph, std::vector<Drawable *> *matches = NULL);
+
+        //returns true iff the statement assigns to a trait
+        bool isAssignment();
+
+    private:
+        //run every step for rows [start, end) of frames, then assign or record matches for them
+        void runBlock(const std::vector<TraitFrame *> &frames, int start, int end,
+                      std::vector<ExprRegister> &regs, std::vector<char> &hit,
+                      long long *done, long long *conflicts);
+
+        string source;
+        DrawableKind kind;
+        ExprProgram program;
+};
+
+#endif
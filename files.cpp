@@ -1,6 +1,30 @@
 #include "files.h"
 #include <fstream>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include <stdio.h>
+#ifdef _WIN32
+#include <io.h>
+#include <process.h>
+#define FSYNC _commit
+#define GETPID _getpid
+#else
+#include <unistd.h>
+#define FSYNC fsync
+#define GETPID getpid
+#endif
+
+//objects formatted per chunk when saving, and chunks formatted ahead of the writer
+#define SAVE_CHUNK (4096)
+#define SAVE_WINDOW (64)
+
 //used for automatically distributing nodes in a circle
 #include <math.h>
 
@@ -9,24 +33,63 @@ std::vector<Drawable *> loadGraph(string fileName) {
     std::unordered_map<string, GraphNode *> nodes;
     std::vector<Drawable *> ret;
 
-    string lines[3] = {""};
     std::ifstream f;
     f.open(fileName);
     if(f.fail()) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "loadGraph failed to open file.");
         return ret;
     }
+
+    std::vector<GraphNode *> unplaced;
+    int positioned = readGraph(f, nodes, ret, false, &unplaced);
+    f.close();
+    
+    if(positioned < 0 || unplaced.empty()) {
+        //either the file was malformed, or it carried its own layout
+        return ret;
+    }
+
+    //only nodes the file did not place are laid out -- given positions are kept
+    layoutCircle(unplaced);
+
+    return ret;
+}
+
+void layoutCircle(std::vector<GraphNode *> &nodes) {
+    //space all nodes around a circle
+    for(int i = 0; i < nodes.size(); i++) {
+        circlePosition(i, nodes.size(), &nodes[i]->x, &nodes[i]->y);
+    }
+}
+
+void circlePosition(int i, int count, double *x, double *y) {
+    double radius = count / 2;
+    double theta = i * (3.1415 * 2.0) / count;
+    *x = radius * cos(theta);
+    *y = radius * sin(theta);
+}
+
+int readGraph(std::istream &f, std::unordered_map<string, GraphNode *> &nodes,
+              std::vector<Drawable *> &out, bool allowPartial, std::vector<GraphNode *> *unplaced) {
+    string lines[3] = {""};
     
     GraphEdge *e = NULL;
     GraphNode *n1 = NULL;
     GraphNode *n2 = NULL;
+    GraphNode *activeNode = NULL;
     TraitFrame *activeTraits = NULL;
+    TraitFrame discarded;
     bool action;
+    int positioned = 0;
+    //nodes read so far which have not been given a position, when the caller asks for them
+    std::vector<GraphNode *> created;
+    std::unordered_set<GraphNode *> placed;
     
     //this uses a rotating buffer of the last three lines seen
     //a new node is defined in two lines -- Node, and its label
     //a new edge is defined in three lines -- Edge, and two labels for nodes
     //any trait is defined in three lines -- type, label, value
+    //a node's position is defined in three lines -- Position, x, y
     while(std::getline(f, lines[2])) {
         //assume an action happens -- set to false if all checks fall through
         action = true;
@@ -35,52 +98,67 @@ std::vector<Drawable *> loadGraph(string fileName) {
         if(lines[2] == "") {
             //blank line -- delineates objects, reset active trait frame
             activeTraits = NULL;
+            activeNode = NULL;
         } else if(lines[1] == "Node") {
             //previous line calls for new node
             if(activeTraits) {
                 SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, 
                              "Attempt to create a new node before finishing previous object.");
-                return ret;
+                return -1;
             }
             if(nodes.count(lines[2])) {
                 SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Duplicate node label: \"%s\"",
                              lines[2].c_str());
-                return ret;
+                return -1;
             } else {
                 //render position nondetermined at this stage
                 n1 = new GraphNode(0, 0, lines[2]);
                 nodes[lines[2]] = n1;
-                ret.push_back(n1);
+                out.push_back(n1);
                 activeTraits = &(n1->traits);
+                activeNode = n1;
+                if(unplaced) {
+                    created.push_back(n1);
+                }
             }
         } else if(lines[0] == "Edge") {
             //two lines ago calls for new edge
             if(activeTraits) {
                 SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, 
                              "Attempt to create a new edge before finishing previous object.");
-                return ret;
+                return -1;
             }
-            if(nodes.count(lines[1])) {
-                n1 = nodes[lines[1]];
+            auto i1 = nodes.find(lines[1]);
+            auto i2 = nodes.find(lines[2]);
+            n1 = (i1 == nodes.end()) ? NULL : i1->second;
+            n2 = (i2 == nodes.end()) ? NULL : i2->second;
+            if(!(n1 && n2)) {
+                if(!allowPartial) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                                 "Unrecognized node label: \"%s\"", (n1 ? lines[2] : lines[1]).c_str());
+                    return -1;
+                }
+                //one end is not present -- traits of this edge are read into a scratch frame and dropped
+                discarded = TraitFrame();
+                activeTraits = &discarded;
             } else {
-                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-                             "Unrecognized node label: \"%s\"", lines[1].c_str());
-                n1 = NULL;
+                activeTraits = n1->linkBundled(n2, &e);
+                if(e) {
+                    out.push_back(e);
+                }
             }
-            if(nodes.count(lines[2])) {
-                n2 = nodes[lines[2]];
-            } else {
+        } else if(lines[0] == "Position") {
+            if(!activeNode) {
                 SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-                             "Unrecognized node label: \"%s\"", lines[1].c_str());
-                n2 = NULL;
-            }
-            if(!(n1 && n2)) {
-                return ret;
+                             "Attempted to set a position with no active node.");
+            } else {
+                activeNode->x = stod(lines[1]);
+                activeNode->y = stod(lines[2]);
+                positioned++;
+                if(unplaced) {
+                    placed.insert(activeNode);
+                }
             }
-
-            e = new GraphEdge(n1, n2);
-            ret.push_back(e);
-            activeTraits = &(e->traits);
         } else if(lines[0] == "Int") {
             if(!activeTraits) {
                 SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
@@ -115,64 +193,147 @@ std::vector<Drawable *> loadGraph(string fileName) {
             lines[1] = lines[2];
         }
     }
-    f.close();
-    
 
-    //space all nodes around a circle
-    double radius = nodes.size() / 2;
-    double theta = 0;
-    double stepAngle = (3.1415 * 2.0) / nodes.size();
-    for(auto i = nodes.begin(); i != nodes.end(); ++i) {
-        i->second->x = radius * cos(theta);
-        i->second->y = radius * sin(theta);
-        theta += stepAngle;
+    if(unplaced) {
+        for(int i = 0; i < created.size(); i++) {
+            if(!placed.count(created[i])) {
+                unplaced->push_back(created[i]);
+            }
+        }
     }
-
-    return ret;
+    return positioned;
 }
 
-void saveGraph(std::vector<Drawable *> g, string fileName) {
-    std::ofstream f;
-    f.open(fileName);
-    if(f.fail()) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "saveGraph failed to open file.");
-        return;
-    }
-
-    GraphNode *n;
-    GraphEdge *e;
+void saveGraph(const std::vector<Drawable *> &g, string fileName) {
+    std::vector<GraphNode *> nodes;
     std::vector<GraphEdge *> edges;
     for(int i = 0; i < g.size(); i++) {
-        n = dynamic_cast<GraphNode *>(g[i]);
-        e = dynamic_cast<GraphEdge *>(g[i]);
-        if(n) {
-            f << "Node" << std::endl;
-            f << n->label << std::endl;
-            n->traits.save(f);
-        } else if(e) {
-            //Current parsing of graph files does only a single pass
-            //an edge cannot be declared before either of its nodes
-            //the drawable registry does not provide strict guarantees of order
-            //standardizing output files to place edges last guarantees readability of file
-            edges.push_back(e);
+        if(g[i]->getState() == ExpiredS) {
+            //marked for deletion, but not yet removed from the registry
+            continue;
+        }
+        switch(g[i]->kind()) {
+            case NodeK:
+                nodes.push_back(static_cast<GraphNode *>(g[i]));
+                break;
+            case EdgeK:
+                //Current parsing of graph files does only a single pass
+                //an edge cannot be declared before either of its nodes
+                //the drawable registry does not provide strict guarantees of order
+                //standardizing output files to place edges last guarantees readability of file
+                edges.push_back(static_cast<GraphEdge *>(g[i]));
+                break;
+            default:
+                //this is not necessarily an error.
+                //future saving will also support context, like drawing position of nodes
+                //future drawables could include annotation objects
+                //these would not be part of the logical graph, but saving them may be desirable
+                SDL_Log("Non-graph drawable present in saveGraph.");
+                break;
+        }
+    }
+
+    int nodeChunks = (nodes.size() + SAVE_CHUNK - 1) / SAVE_CHUNK;
+    int edgeChunks = (edges.size() + SAVE_CHUNK - 1) / SAVE_CHUNK;
+    writeChunked(fileName, nodeChunks + edgeChunks, [&](int chunk, string &out) {
+        if(chunk < nodeChunks) {
+            int end = std::min((int)nodes.size(), (chunk + 1) * SAVE_CHUNK);
+            for(int i = chunk * SAVE_CHUNK; i < end; i++) {
+                nodes[i]->save(out);
+            }
         } else {
-            //this is not necessarily an error.
-            //future saving will also support context, like drawing position of nodes
-            //future drawables could include annotation objects
-            //these would not be part of the logical graph, but saving them may be desirable
-            SDL_Log("Non-graph drawable present in saveGraph.");
+            chunk -= nodeChunks;
+            int end = std::min((int)edges.size(), (chunk + 1) * SAVE_CHUNK);
+            for(int i = chunk * SAVE_CHUNK; i < end; i++) {
+                edges[i]->save(out);
+            }
+        }
+    });
+}
+
+int writeChunked(string fileName, int chunks, std::function<void(int, string &)> format) {
+    //each write gets its own temporary file, so writes of the same file from other threads or processes
+    //cannot truncate or interleave with this one -- whichever is renamed last wins, whole
+    static std::atomic<unsigned> writes(0);
+    string tempName = fileName + "." + std::to_string(GETPID()) + "." + std::to_string(writes++) + ".tmp";
+    FILE *f = fopen(tempName.c_str(), "wb");
+    if(!f) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open \"%s\" for writing.", tempName.c_str());
+        return 1;
+    }
+
+    //formatted chunks wait here until every chunk before them has been written
+    //workers stay at most SAVE_WINDOW chunks ahead of the writer, bounding the memory used
+    std::vector<string> done(chunks);
+    std::vector<char> ready(chunks, 0);
+    std::mutex lock;
+    std::condition_variable changed;
+    int written = 0;
+    int next = 0;
+    bool failed = false;
+
+    auto work = [&]() {
+        std::unique_lock<std::mutex> guard(lock);
+        while(true) {
+            changed.wait(guard, [&]() { return next >= chunks || next < written + SAVE_WINDOW || failed; });
+            if(next >= chunks || failed) {
+                return;
+            }
+            int chunk = next++;
+            guard.unlock();
+            string out;
+            format(chunk, out);
+            guard.lock();
+            done[chunk] = std::move(out);
+            ready[chunk] = 1;
+            changed.notify_all();
         }
-        f << std::endl;
+    };
+
+    int threadCount = std::max(1, std::min((int)std::thread::hardware_concurrency(), chunks));
+    std::vector<std::thread> threads;
+    for(int i = 0; i < threadCount; i++) {
+        threads.push_back(std::thread(work));
     }
-    for(int i = 0; i < edges.size(); i++) {
-        SDL_Log("%d", i);
-        e = edges[i];
-        f << "Edge" << std::endl;
-        f << e->nodes[0]->label << std::endl;
-        f << e->nodes[1]->label << std::endl;
-        e->traits.save(f);
-        f << std::endl;
+
+    std::unique_lock<std::mutex> guard(lock);
+    while(written < chunks && !failed) {
+        changed.wait(guard, [&]() { return ready[written] != 0; });
+        string out = std::move(done[written]);
+        guard.unlock();
+        bool writeFailed = fwrite(out.data(), 1, out.size(), f) != out.size();
+        guard.lock();
+        if(writeFailed) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed writing to \"%s\".", tempName.c_str());
+            failed = true;
+        }
+        written++;
+        changed.notify_all();
     }
-    f.close();
-}
+    guard.unlock();
+    for(int i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    //make sure the data is on disk before the rename makes it the real file
+    if(!failed && (fflush(f) || FSYNC(fileno(f)))) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed flushing \"%s\" to disk.", tempName.c_str());
+        failed = true;
+    }
+    fclose(f);
 
+    std::error_code err;
+    if(!failed) {
+        std::filesystem::rename(tempName, fileName, err);
+        if(err) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to replace \"%s\": %s",
+                         fileName.c_str(), err.message().c_str());
+            failed = true;
+        }
+    }
+    if(failed) {
+        std::filesystem::remove(tempName, err);
+        return 1;
+    }
+    return 0;
+}
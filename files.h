@@ -2,15 +2,41 @@
 #ifndef FILES_H
 #define FILES_H
 
+#include <functional>
+
 #include "graphs.h"
 
 //function to read in a file containing a graph
 //returns a vector containing every edge and node
 std::vector<Drawable *> loadGraph(string fileName);
 
+//function to read graph objects from an already-open stream
+//labels are resolved through the given map, and newly read nodes are added to it
+//every created node and edge is appended to out
+//if allowPartial is set, edges naming an unknown node are skipped rather than treated as errors
+//if unplaced is given, every node read without a position is appended to it, in the order read
+//returns the number of nodes which had a position given, or -1 if reading stopped on an error
+int readGraph(std::istream &f, std::unordered_map<string, GraphNode *> &nodes,
+              std::vector<Drawable *> &out, bool allowPartial,
+              std::vector<GraphNode *> *unplaced = NULL);
+
+//function to space nodes evenly around a circle, with a radius scaled to their count
+void layoutCircle(std::vector<GraphNode *> &nodes);
+
+//function to find where layoutCircle places the i-th of count nodes
+//lets a layout be computed for nodes which are never all in memory at once
+void circlePosition(int i, int count, double *x, double *y);
+
 //function to save a graph to a file
 //writes in a format which loadGraph can read
 //  currently label uniqueness is guaranteed only in reading
 //  it is technically possible to save a graph which cannot be read.
-void saveGraph(std::vector<Drawable *> graph, string fileName);
+//nodes and edges are formatted on several threads, and the file is replaced atomically
+void saveGraph(const std::vector<Drawable *> &graph, string fileName);
+
+//function to write a file as a sequence of chunks, which are formatted in parallel
+//format(i, out) must append chunk i to out -- it is called from several threads at once
+//chunks are written in order to a temporary file, which is flushed to disk and renamed over fileName
+//returns nonzero iff error, in which case fileName is left untouched
+int writeChunked(string fileName, int chunks, std::function<void(int, string &)> format);
 #endif
@@ -0,0 +1,265 @@
+#include "focus.h"
+
+#include <math.h>
+#include <unordered_set>
+
+//space given to each node around a ring, and the least gap between rings
+#define NODE_SPACING (3.0)
+#define RING_GAP (4.0)
+
+FocusView::FocusView() {
+    centerNode = NULL;
+    changed = true;
+}
+
+void FocusView::focus(GraphNode *center, int k) {
+    clear();
+    centerNode = center;
+    distance[center] = Place{0, 0};
+    rings.push_back(std::vector<GraphNode *>(1, center));
+    ringRadius.push_back(0);
+    ringEdges.push_back(std::vector<GraphEdge *>());
+    collectEdges(0);
+    setRadius(k);
+    SDL_Log("Focused on \"%s\": %d nodes within %d hops.", center->label.c_str(),
+            (int)distance.size(), radius());
+}
+
+void FocusView::setRadius(int k) {
+    if(!isActive()) {
+        return;
+    }
+    if(k < 0) {
+        k = 0;
+    }
+    while(radius() > k) {
+        shrink();
+    }
+    while(radius() < k && grow()) {}
+}
+
+void FocusView::clear() {
+    for(auto i = home.begin(); i != home.end(); ++i) {
+        i->first->x = i->second.first;
+        i->first->y = i->second.second;
+    }
+    home.clear();
+    distance.clear();
+    edgeRing.clear();
+    rings.clear();
+    ringRadius.clear();
+    ringEdges.clear();
+    extras.clear();
+    view.clear();
+    centerNode = NULL;
+    changed = true;
+}
+
+bool FocusView::isActive() {
+    return centerNode != NULL;
+}
+
+GraphNode *FocusView::center() {
+    return centerNode;
+}
+
+int FocusView::radius() {
+    return (int)rings.size() - 1;
+}
+
+double FocusView::extent() {
+    return ringRadius.empty() ? 0 : ringRadius.back();
+}
+
+const std::vector<Drawable *> &FocusView::members() {
+    if(changed) {
+        view.clear();
+        for(int d = 0; d < rings.size(); d++) {
+            view.insert(view.end(), rings[d].begin(), rings[d].end());
+            view.insert(view.end(), ringEdges[d].begin(), ringEdges[d].end());
+        }
+        for(int i = 0; i < extras.size(); i++) {
+            //an edge made while focused may have lost an end to a shrinking ring
+            GraphEdge *e = dynamic_cast<GraphEdge *>(extras[i]);
+            if(e && !(distance.count(e->nodes[0]) && distance.count(e->nodes[1]))) {
+                continue;
+            }
+            view.push_back(extras[i]);
+        }
+        changed = false;
+    }
+    return view;
+}
+
+void FocusView::add(Drawable *d) {
+    if(!isActive()) {
+        return;
+    }
+    if(d->kind() == NodeK) {
+        distance[static_cast<GraphNode *>(d)] = Place{-1, (int)extras.size()};
+    } else if(d->kind() == EdgeK) {
+        GraphEdge *e = static_cast<GraphEdge *>(d);
+        if(!(distance.count(e->nodes[0]) && distance.count(e->nodes[1]))) {
+            return;
+        }
+        edgeRing[e] = Place{-1, (int)extras.size()};
+    } else {
+        return;
+    }
+    extras.push_back(d);
+    changed = true;
+}
+
+FocusView::Place &FocusView::placeOf(Drawable *d) {
+    if(d->kind() == NodeK) {
+        return distance[static_cast<GraphNode *>(d)];
+    }
+    return edgeRing[static_cast<GraphEdge *>(d)];
+}
+
+template <typename T>
+void FocusView::removeAt(std::vector<T *> &list, int slot) {
+    list[slot] = list.back();
+    placeOf(list[slot]).slot = slot;
+    list.pop_back();
+}
+
+void FocusView::moved(GraphNode *n) {
+    auto h = home.find(n);
+    if(h != home.end()) {
+        h->second = std::make_pair(n->x, n->y);
+    }
+}
+
+void FocusView::release(Drawable *d) {
+    if(!isActive()) {
+        return;
+    }
+    if(d->kind() == NodeK) {
+        GraphNode *n = static_cast<GraphNode *>(d);
+        auto i = distance.find(n);
+        if(i == distance.end()) {
+            return;
+        }
+        if(i->second.ring < 0) {
+            removeAt(extras, i->second.slot);
+        } else {
+            removeAt(rings[i->second.ring], i->second.slot);
+        }
+        distance.erase(n);
+        home.erase(n);
+        changed = true;
+        if(n == centerNode) {
+            //nothing left to focus on -- put the rest back
+            clear();
+        }
+    } else if(d->kind() == EdgeK) {
+        GraphEdge *e = static_cast<GraphEdge *>(d);
+        auto i = edgeRing.find(e);
+        if(i == edgeRing.end()) {
+            return;
+        }
+        if(i->second.ring < 0) {
+            removeAt(extras, i->second.slot);
+        } else {
+            removeAt(ringEdges[i->second.ring], i->second.slot);
+        }
+        edgeRing.erase(e);
+        changed = true;
+    }
+}
+
+bool FocusView::grow() {
+    int d = rings.size();
+    std::vector<GraphNode *> &outer = rings.back();
+    std::vector<GraphNode *> next;
+    for(int i = 0; i < outer.size(); i++) {
+        GraphNode *n = outer[i];
+        for(int j = 0; j < n->edges.size(); j++) {
+            GraphEdge *e = n->edges[j];
+            if(e->getState() == ExpiredS) {
+                continue;
+            }
+            GraphNode *m = e->from(n);
+            if(m && distance.emplace(m, Place{d, (int)next.size()}).second) {
+                next.push_back(m);
+            }
+        }
+    }
+
+    if(next.empty() || distance.size() > FOCUS_LIMIT) {
+        if(next.empty()) {
+            SDL_Log("Nothing lies %d hops from \"%s\".", d, centerNode->label.c_str());
+        } else {
+            SDL_Log("Growing focus to %d hops would pass %d nodes.", d, FOCUS_LIMIT);
+        }
+        for(int i = 0; i < next.size(); i++) {
+            distance.erase(next[i]);
+        }
+        return false;
+    }
+
+    //nodes are found in the order of the ring inside, so neighbors of adjacent parents stay adjacent
+    double needed = next.size() * NODE_SPACING / (2 * M_PI);
+    double r = fmax(ringRadius.back() + RING_GAP, needed);
+    for(int i = 0; i < next.size(); i++) {
+        GraphNode *n = next[i];
+        home[n] = std::make_pair(n->x, n->y);
+        double angle = 2 * M_PI * i / next.size();
+        n->x = centerNode->x + r * cos(angle);
+        n->y = centerNode->y + r * sin(angle);
+    }
+
+    rings.push_back(std::move(next));
+    ringRadius.push_back(r);
+    ringEdges.push_back(std::vector<GraphEdge *>());
+    collectEdges(d);
+    changed = true;
+    return true;
+}
+
+void FocusView::shrink() {
+    int d = radius();
+    std::vector<GraphNode *> &outer = rings.back();
+    for(int i = 0; i < outer.size(); i++) {
+        GraphNode *n = outer[i];
+        auto h = home.find(n);
+        if(h != home.end()) {
+            n->x = h->second.first;
+            n->y = h->second.second;
+            home.erase(h);
+        }
+        distance.erase(n);
+    }
+    for(int i = 0; i < ringEdges[d].size(); i++) {
+        edgeRing.erase(ringEdges[d][i]);
+    }
+    rings.pop_back();
+    ringRadius.pop_back();
+    ringEdges.pop_back();
+    changed = true;
+}
+
+void FocusView::collectEdges(int d) {
+    //each edge is kept with its farther end, so the edges of a ring leave along with it
+    //a ring's edges all touch its nodes, so only they need to be scanned
+    std::unordered_set<GraphEdge *> seen;
+    std::vector<GraphNode *> &ring = rings[d];
+    for(int i = 0; i < ring.size(); i++) {
+        GraphNode *n = ring[i];
+        for(int j = 0; j < n->edges.size(); j++) {
+            GraphEdge *e = n->edges[j];
+            if(e->getState() == ExpiredS) {
+                continue;
+            }
+            auto m = distance.find(e->from(n));
+            if(m == distance.end() || m->second.ring < 0 || m->second.ring > d) {
+                continue;
+            }
+            if(seen.insert(e).second) {
+                edgeRing[e] = Place{d, (int)ringEdges[d].size()};
+                ringEdges[d].push_back(e);
+            }
+        }
+    }
+}
@@ -0,0 +1,91 @@
+//defines a view of the k-hop neighborhood around one node, for working in part of a large graph
+#ifndef FOCUS_H
+#define FOCUS_H
+
+#include "graphs.h"
+
+//most nodes a view may hold
+#define FOCUS_LIMIT (200000)
+
+//every node within k hops of a center node, and every live edge between them
+//the neighborhood is found by a breadth-first search bounded by k, so the rest of the graph is never visited
+//nodes are laid out in rings around the center by hop distance, and put back when they leave the view
+//changing k only searches, lays out or restores the rings being added or removed
+class FocusView {
+    public:
+        FocusView();
+
+        //focus on the neighborhood of a node, first putting back any previous focus
+        void focus(GraphNode *center, int k);
+
+        //grow or shrink the neighborhood to k hops
+        //growth stops early, with a message, rather than pass FOCUS_LIMIT nodes
+        void setRadius(int k);
+
+        //put every node back where it was, and stop focusing
+        void clear();
+
+        //returns true iff a node is focused
+        bool isActive();
+
+        GraphNode *center();
+        int radius();
+
+        //distance from the center to the outermost ring, for fitting the camera to the view
+        double extent();
+
+        //every node and edge in the view, for drawing and clicking
+        const std::vector<Drawable *> &members();
+
+        //include an object created while focused -- edges are only included if both ends are in view
+        //distances are not updated, so new edges do not pull in more of the graph until focus is reset
+        void add(Drawable *d);
+
+        //forget a drawable which the registry owner is about to delete
+        //must be called for every deleted drawable while focused
+        void release(Drawable *d);
+
+        //a node was moved by the user -- if it is in view, it stays where it was put once it leaves
+        void moved(GraphNode *n);
+
+    private:
+        //search one hop outward from the outermost ring, returning false if that would pass the limit
+        bool grow();
+        //drop the outermost ring, putting its nodes back
+        void shrink();
+        //find the edges of ring d which lead back to it or inward
+        void collectEdges(int d);
+
+        //where a member is kept -- its ring, or -1 for objects created while focused, and its slot in that list
+        struct Place {
+            int ring;
+            int slot;
+        };
+        Place &placeOf(Drawable *d);
+        //take the member at a slot out of a list whose order does not matter, moving the last member into its place
+        template <typename T>
+        void removeAt(std::vector<T *> &list, int slot);
+
+        GraphNode *centerNode;
+
+        //nodes at each hop distance, and the radius of the ring they are laid out on
+        std::vector<std::vector<GraphNode *>> rings;
+        std::vector<double> ringRadius;
+        //edges whose farther end is at each hop distance
+        std::vector<std::vector<GraphEdge *>> ringEdges;
+        //objects created while focused
+        std::vector<Drawable *> extras;
+
+        //hop distance of every node in view, which is also its ring, and its slot there
+        std::unordered_map<GraphNode *, Place> distance;
+        //ring each edge in view is kept with, and its slot there
+        std::unordered_map<GraphEdge *, Place> edgeRing;
+        //position of every node before it was laid out in a ring
+        std::unordered_map<GraphNode *, std::pair<double, double>> home;
+
+        //members, rebuilt when the view changes
+        std::vector<Drawable *> view;
+        bool changed;
+};
+
+#endif
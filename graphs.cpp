@@ -1,101 +1,192 @@
 #include "graphs.h"
+#include "stats.h"
+#include "styles.h"
+
+#include <charconv>
+#include <math.h>
+#include <stdio.h>
 
 //initialize total nodes to zero
 int GraphNode::totalNodes = 0;
 
+//parallel connections are separate edges unless asked for
+bool GraphNode::bundleEdges = false;
+
+//set while deleteGraph runs, so destructors skip logging and statistics
+//per thread, as a graph may be deleted off to the side while another thread edits the one in use
+static thread_local bool deletingGraph = false;
+
+//heap memory held by a string, zero if it fits in the string's own storage
+static long long heapBytes(const string &s) {
+    static const size_t inlineCapacity = string().capacity();
+    return (s.capacity() > inlineCapacity) ? s.capacity() + 1 : 0;
+}
+
 TraitFrame::TraitFrame() {
-    //no special action needed -- current internal containers handle themselves
+    data = std::allocate_shared<TraitData>(TrackingAllocator<TraitData, TraitM>());
+    changes = 0;
+}
+
+TraitFrame::TraitFrame(const TraitFrame &old) {
+    //the containers are shared until either frame is written to
+    data = old.data;
+    changes = old.changes;
+}
+
+TraitFrame &TraitFrame::operator=(const TraitFrame &old) {
+    data = old.data;
+    changes++;
+    return *this;
 }
 
-TraitFrame::TraitFrame(TraitFrame &old) {
-    traitInts = old.traitInts;
-    traitDoubles = old.traitDoubles;
-    traitStrings = old.traitStrings;
+void TraitFrame::detach() {
+    //every write comes through here, so this is where changes are counted
+    changes++;
+    if(data.use_count() > 1) {
+        data = std::allocate_shared<TraitData>(TrackingAllocator<TraitData, TraitM>(), *data);
+    } else {
+        //the last other owner may have been reading from another thread
+        //make sure those reads are complete before writing
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+}
+
+void TraitFrame::relocate() {
+    data = std::allocate_shared<TraitData>(TrackingAllocator<TraitData, TraitM>(), *data);
 }
 
 //temporary print function
 void TraitFrame::tempPrint() {
     SDL_Log("Ints:");
-    for(auto i = traitInts.begin(); i != traitInts.end(); ++i) {
+    for(auto i = data->traitInts.begin(); i != data->traitInts.end(); ++i) {
         SDL_Log("\t%s: %d", i->first.c_str(), i->second);
     }
     SDL_Log("Doubles:");
-    for(auto i = traitDoubles.begin(); i != traitDoubles.end(); ++i) {
+    for(auto i = data->traitDoubles.begin(); i != data->traitDoubles.end(); ++i) {
         SDL_Log("\t%s: %lf", i->first.c_str(), i->second);
     }
     SDL_Log("Strings:");
-    for(auto i = traitStrings.begin(); i != traitStrings.end(); ++i) {
+    for(auto i = data->traitStrings.begin(); i != data->traitStrings.end(); ++i) {
         SDL_Log("\t%s: %s", i->first.c_str(), i->second.c_str());
     }
 }
 
 void TraitFrame::addInt(string label, int value) {
-    if(traitDoubles.count(label) || traitStrings.count(label)) {
+    detach();
+    if(data->traitDoubles.count(label) || data->traitStrings.count(label)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Tried to add duplicate trait: %s", label.c_str());
     } else {
-        traitInts[label] = value;
+        data->traitInts[label] = value;
     }
 }
 
 void TraitFrame::addDouble(string label, double value) {
-    if(traitInts.count(label) || traitStrings.count(label)) {
+    detach();
+    if(data->traitInts.count(label) || data->traitStrings.count(label)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Tried to add duplicate trait: %s", label.c_str());
     } else {
-        traitDoubles[label] = value;
+        data->traitDoubles[label] = value;
     }
 }
 
 void TraitFrame::addString(string label, string value) {
-    if(traitInts.count(label) || traitDoubles.count(label)) {
+    detach();
+    if(data->traitInts.count(label) || data->traitDoubles.count(label)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Tried to add duplicate trait: %s", label.c_str());
     } else {
-        traitStrings[label] = value;
+        data->traitStrings[label] = value;
     }
 }
 
 std::vector<string> TraitFrame::listLabels() {
     std::vector<string> ret;
-    for(auto i = traitInts.begin(); i != traitInts.end(); ++i) {
+    for(auto i = data->traitInts.begin(); i != data->traitInts.end(); ++i) {
         ret.push_back(i->first);
     }
-    for(auto i = traitDoubles.begin(); i != traitDoubles.end(); ++i) {
+    for(auto i = data->traitDoubles.begin(); i != data->traitDoubles.end(); ++i) {
         ret.push_back(i->first);
     }
-    for(auto i = traitStrings.begin(); i != traitStrings.end(); ++i) {
+    for(auto i = data->traitStrings.begin(); i != data->traitStrings.end(); ++i) {
         ret.push_back(i->first);
     }
     return ret;
 }
 
 TraitType TraitFrame::lookup(string label, void **ret) {
-    if(traitInts.count(label)) {
+    //the returned pointer allows writing, so this frame must have its own containers
+    detach();
+    if(data->traitInts.count(label)) {
         //inefficient to count and then retrieve separately -- the internal lookup is done twice
         //hashmaps are efficient, so this is unlikely to matter
         //may cause slowdowns with scripts later
-        *ret = &traitInts[label];
+        *ret = &data->traitInts[label];
         return IntT;
-    } else if(traitDoubles.count(label)) {
-        *ret = &traitDoubles[label];
+    } else if(data->traitDoubles.count(label)) {
+        *ret = &data->traitDoubles[label];
         return DoubleT;
-    } else if(traitStrings.count(label)) {
-        *ret = &traitStrings[label];
+    } else if(data->traitStrings.count(label)) {
+        *ret = &data->traitStrings[label];
         return StringT;
     }
     return NoneT;
 }
 
+TraitType TraitFrame::get(const string &label, const void **ret) const {
+    auto i = data->traitInts.find(label);
+    if(i != data->traitInts.end()) {
+        *ret = &i->second;
+        return IntT;
+    }
+    auto d = data->traitDoubles.find(label);
+    if(d != data->traitDoubles.end()) {
+        *ret = &d->second;
+        return DoubleT;
+    }
+    auto s = data->traitStrings.find(label);
+    if(s != data->traitStrings.end()) {
+        *ret = &s->second;
+        return StringT;
+    }
+    return NoneT;
+}
+
+unsigned TraitFrame::version() const {
+    return changes;
+}
+
 //function to write the traits to a given file
 void TraitFrame::save(std::ofstream &f) {
-    for(auto i = traitInts.begin(); i != traitInts.end(); ++i) {
-        f << "Int" << std::endl << i->first << std::endl << i->second << std::endl;
+    string buf;
+    save(buf);
+    f << buf;
+}
+
+//function to append the traits to a buffer
+//values are formatted as a default-configured stream would, so files match older saves
+void TraitFrame::save(string &out) const {
+    char num[32];
+    for(auto i = data->traitInts.begin(); i != data->traitInts.end(); ++i) {
+        out += "Int\n";
+        out += i->first;
+        out += '\n';
+        out.append(num, std::to_chars(num, num + sizeof(num), i->second).ptr - num);
+        out += '\n';
     }
 
-    for(auto i = traitDoubles.begin(); i != traitDoubles.end(); ++i) {
-        f << "Double" << std::endl << i->first << std::endl << i->second << std::endl;
+    for(auto i = data->traitDoubles.begin(); i != data->traitDoubles.end(); ++i) {
+        out += "Double\n";
+        out += i->first;
+        out += '\n';
+        out.append(num, snprintf(num, sizeof(num), "%g", i->second));
+        out += '\n';
     }
 
-    for(auto i = traitStrings.begin(); i != traitStrings.end(); ++i) {
-        f << "String" << std::endl << i->first << std::endl << i->second << std::endl;
+    for(auto i = data->traitStrings.begin(); i != data->traitStrings.end(); ++i) {
+        out += "String\n";
+        out += i->first;
+        out += '\n';
+        out += i->second;
+        out += '\n';
     }
 }
 
@@ -110,6 +201,8 @@ GraphNode::GraphNode(double inX, double inY, string inLabel) {
         label = inLabel;
     }
 
+    quiet = false;
+
     traits.addInt("times_clicked", 0);
     traits.addInt("node_id", totalNodes);
     traits.addDouble("value", 0.5);
@@ -117,10 +210,51 @@ GraphNode::GraphNode(double inX, double inY, string inLabel) {
 
 
     totalNodes++;
+    statsNodeAdded(this);
+    memoryAdd(NodeM, sizeof(GraphNode));
+    if(heapBytes(label)) {
+        memoryAdd(LabelM, heapBytes(label));
+    }
+}
+
+GraphNode::GraphNode(GraphNode *old) : traits(old->traits) {
+    x = old->x;
+    y = old->y;
+    state = old->state;
+    style = old->style;
+    //copied rather than moved, so the new label and edge list are allocated alongside the new node
+    label = old->label;
+    edges = old->edges;
+    traits.relocate();
+    quiet = false;
+
+    statsNodeMoved(old, this);
+    for(int i = 0; i < edges.size(); i++) {
+        //both ends are checked -- a self-cycle points at this node twice
+        for(int j = 0; j < 2; j++) {
+            if(edges[i]->nodes[j] == old) {
+                edges[i]->nodes[j] = this;
+            }
+        }
+    }
+    old->edges.clear();
+    old->quiet = true;
+
+    memoryAdd(NodeM, sizeof(GraphNode));
+    if(heapBytes(label)) {
+        memoryAdd(LabelM, heapBytes(label));
+    }
 }
 
 GraphNode::~GraphNode() {
-    SDL_Log("Deleted node labeled \"%s\"", label.c_str());
+    if(!quiet && !deletingGraph) {
+        SDL_Log("Deleted node labeled \"%s\"", label.c_str());
+        statsNodeRemoved(this);
+    }
+    memoryRemove(NodeM, sizeof(GraphNode));
+    if(heapBytes(label)) {
+        memoryRemove(LabelM, heapBytes(label));
+    }
 }
 
 int GraphNode::onClick(double inX, double inY) {
@@ -130,7 +264,7 @@ int GraphNode::onClick(double inX, double inY) {
     //revisit in drawing-rework and when redoing ui
     double dx = inX - x;
     double dy = inY - y;
-    if((dx * dx) + (dy * dy) < 1) {
+    if((dx * dx) + (dy * dy) < style.size * style.size) {
         SDL_Log("Node labeled \"%s\" clicked. Traits:", label.c_str());
         traits.tempPrint();
         SDL_Log("Node has %d edges.", edges.size());
@@ -166,11 +300,7 @@ int GraphNode::onClick(double inX, double inY) {
 
         //if shift is pressed, mark the node for deletion, rather than for making a new edge
         if(SDL_GetModState() & KMOD_SHIFT) {
-            state = ExpiredS;
-            //mark all connected edges for deletion as well
-            for(int i = 0; i < edges.size(); i++) {
-                edges[i]->cut(this);
-            }
+            remove();
         } else {
             state = ActiveS;
         }
@@ -179,32 +309,46 @@ int GraphNode::onClick(double inX, double inY) {
     return 0;
 }
 
+DrawableKind GraphNode::kind() {
+    return NodeK;
+}
+
+void GraphNode::save(string &out) {
+    out += "Node\n";
+    out += label;
+    out += '\n';
+    traits.save(out);
+    out += '\n';
+}
+
 void GraphNode::draw() {
-    //draw octagon inside unit-circle for now
+    //draw octagon inside a circle of the styled radius for now
     //support for fancier shapes later, in drawing-rework
     if(state == ExpiredS) {
         return;
     }
+    refreshStyle(style, traits, NodeK);
+    double r = style.size;
 
     glBegin(GL_LINE_LOOP);
-    glColor3d(0, 0, 0);
-    glVertex2d(x + 1, y);
-    glVertex2d(x + 0.707, y + 0.707);
-    glVertex2d(x, y + 1);
-    glVertex2d(x - 0.707, y + 0.707);
-    glVertex2d(x - 1, y);
-    glVertex2d(x - 0.707, y - 0.707);
-    glVertex2d(x, y - 1);
-    glVertex2d(x + 0.707, y - 0.707);
+    glColor3fv(style.color);
+    glVertex2d(x + r, y);
+    glVertex2d(x + 0.707 * r, y + 0.707 * r);
+    glVertex2d(x, y + r);
+    glVertex2d(x - 0.707 * r, y + 0.707 * r);
+    glVertex2d(x - r, y);
+    glVertex2d(x - 0.707 * r, y - 0.707 * r);
+    glVertex2d(x, y - r);
+    glVertex2d(x + 0.707 * r, y - 0.707 * r);
     glEnd();
 
     if(state == ActiveS) {
         //indicate active node for forming connections
         glBegin(GL_LINES);
-        glVertex2d(x - 0.5, y);
-        glVertex2d(x + 0.5, y);
-        glVertex2d(x, y - 0.5);
-        glVertex2d(x, y + 0.5);
+        glVertex2d(x - 0.5 * r, y);
+        glVertex2d(x + 0.5 * r, y);
+        glVertex2d(x, y - 0.5 * r);
+        glVertex2d(x, y + 0.5 * r);
         glEnd();
     }
 }
@@ -214,6 +358,28 @@ GraphEdge *GraphNode::link(GraphNode *g) {
     return new GraphEdge(this, g);
 }
 
+TraitFrame *GraphNode::linkBundled(GraphNode *g, GraphEdge **created) {
+    GraphEdge *e = bundleEdges ? findEdge(g) : NULL;
+    if(e) {
+        *created = NULL;
+        return e->addRow(this);
+    }
+    *created = link(g);
+    return &((*created)->traits);
+}
+
+GraphEdge *GraphNode::findEdge(GraphNode *g) {
+    //search from whichever end has fewer edges
+    GraphNode *source = (g->edges.size() < edges.size()) ? g : this;
+    GraphNode *target = (source == this) ? g : this;
+    for(int i = 0; i < source->edges.size(); i++) {
+        if(source->edges[i]->getState() != ExpiredS && source->edges[i]->from(source) == target) {
+            return source->edges[i];
+        }
+    }
+    return NULL;
+}
+
 void GraphNode::cut(GraphEdge *source) {
     for(int i = 0; i < edges.size(); i++) {
         if(edges[i] == source) {
@@ -226,17 +392,85 @@ void GraphNode::cut(GraphEdge *source) {
     }
 }
 
+void GraphNode::remove() {
+    state = ExpiredS;
+    statsNodeDetached(this);
+    //mark all connected edges for deletion as well
+    for(int i = 0; i < edges.size(); i++) {
+        edges[i]->cut(this);
+    }
+}
+
 GraphEdge::GraphEdge(GraphNode *n1, GraphNode *n2) {
     nodes[0] = n1;
     nodes[1] = n2;
     state = NormalS;
     
+    quiet = false;
+    
     n1->edges.push_back(this);
     n2->edges.push_back(this);
+    statsConnectionAdded(n1, n2);
+    memoryAdd(EdgeM, sizeof(GraphEdge));
+}
+
+GraphEdge::GraphEdge(GraphEdge *old) : traits(old->traits) {
+    nodes[0] = old->nodes[0];
+    nodes[1] = old->nodes[1];
+    state = old->state;
+    style = old->style;
+    rows = old->rows;
+    rowReversed = old->rowReversed;
+    traits.relocate();
+    for(int i = 0; i < rows.size(); i++) {
+        rows[i].relocate();
+    }
+    quiet = false;
+    old->quiet = true;
+    memoryAdd(EdgeM, sizeof(GraphEdge));
 }
 
 GraphEdge::~GraphEdge() {
-    SDL_Log("Deleted edge.");
+    if(!quiet && !deletingGraph) {
+        SDL_Log("Deleted edge.");
+    }
+    memoryRemove(EdgeM, sizeof(GraphEdge));
+}
+
+DrawableKind GraphEdge::kind() {
+    return EdgeK;
+}
+
+void GraphEdge::save(string &out) {
+    //a bundle is written as one edge per connection, each in its own direction, so files do not depend on bundling
+    for(int i = 0; i < count(); i++) {
+        out += "Edge\n";
+        out += connectionFrom(i)->label;
+        out += '\n';
+        out += connectionTo(i)->label;
+        out += '\n';
+        ((i == 0) ? traits : rows[i - 1]).save(out);
+        out += '\n';
+    }
+}
+
+TraitFrame *GraphEdge::addRow(GraphNode *source) {
+    statsConnectionAdded(nodes[0], nodes[1]);
+    rows.push_back(TraitFrame());
+    rowReversed.push_back(source == nodes[1] && source != nodes[0]);
+    return &rows.back();
+}
+
+int GraphEdge::count() {
+    return 1 + rows.size();
+}
+
+GraphNode *GraphEdge::connectionFrom(int i) {
+    return (i > 0 && rowReversed[i - 1]) ? nodes[1] : nodes[0];
+}
+
+GraphNode *GraphEdge::connectionTo(int i) {
+    return (i > 0 && rowReversed[i - 1]) ? nodes[0] : nodes[1];
 }
 
 int GraphEdge::onClick(double x, double y) {
@@ -244,15 +478,34 @@ int GraphEdge::onClick(double x, double y) {
 }
 
 void GraphEdge::draw() {
-    //simple line from n[0] to n[1]
-    //how to show self-cycles? multiplicity?
-    //more complex, let be invisible now, handle in drawing-rework
+    //simple line from n[0] to n[1], thickened by the number of bundled connections
+    //self-cycles are drawn as a loop above their node
+    //unbundled parallel edges still overlap exactly
     if(state != ExpiredS && nodes[0] && nodes[1]) {
-        glBegin(GL_LINES);
-        glColor3d(0, 0, 0);
-        glVertex2d(nodes[0]->x, nodes[0]->y);
-        glVertex2d(nodes[1]->x, nodes[1]->y);
-        glEnd();
+        refreshStyle(style, traits, EdgeK);
+        double width = style.size * (1 + log2(count()));
+        if(width != 1) {
+            glLineWidth(width);
+        }
+        glColor3fv(style.color);
+        if(nodes[0] == nodes[1]) {
+            //circle of radius 0.5, resting on top of the node's circle
+            double cx = nodes[0]->x;
+            double cy = nodes[0]->y + nodes[0]->style.size + 0.5;
+            glBegin(GL_LINE_LOOP);
+            for(int i = 0; i < 12; i++) {
+                glVertex2d(cx + 0.5 * cos(i * 3.1415 / 6), cy + 0.5 * sin(i * 3.1415 / 6));
+            }
+            glEnd();
+        } else {
+            glBegin(GL_LINES);
+            glVertex2d(nodes[0]->x, nodes[0]->y);
+            glVertex2d(nodes[1]->x, nodes[1]->y);
+            glEnd();
+        }
+        if(width != 1) {
+            glLineWidth(1);
+        }
     }
 }
 
@@ -267,7 +520,12 @@ GraphNode *GraphEdge::from(GraphNode *source) {
 }
 
 void GraphEdge::cut(GraphNode *source) {
+    if(state == ExpiredS) {
+        //already cut -- e.g. a self-cycle is listed twice in its node's edges
+        return;
+    }
     state = ExpiredS;
+    GraphNode *ends[2] = {nodes[0], nodes[1]};
     if(source == nodes[0]) {
         //cutting happens when a thing marks itself for deletion
         nodes[0] = NULL;
@@ -281,7 +539,29 @@ void GraphEdge::cut(GraphNode *source) {
     } else {
         nodes[1]->cut(this);
     }
+    statsEdgeRemoved(ends[0], ends[1], count());
 }
 
+void unloadNodes(const std::vector<GraphNode *> &nodes) {
+    for(int i = 0; i < nodes.size(); i++) {
+        nodes[i]->state = ExpiredS;
+        nodes[i]->quiet = true;
+    }
+    statsNodesUnloaded(nodes);
+    for(int i = 0; i < nodes.size(); i++) {
+        GraphNode *n = nodes[i];
+        for(int j = 0; j < n->edges.size(); j++) {
+            n->edges[j]->quiet = true;
+            n->edges[j]->cut(n);
+        }
+    }
+}
 
-
+void deleteGraph(std::vector<Drawable *> &graph) {
+    deletingGraph = true;
+    for(int i = 0; i < graph.size(); i++) {
+        delete graph[i];
+    }
+    deletingGraph = false;
+    graph.clear();
+}
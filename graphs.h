@@ -2,12 +2,15 @@
 #ifndef GRAPHS_H
 #define GRAPHS_H
 
+#include <atomic>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
 #include <fstream>
 
 #include "drawing.h"
+#include "memory.h"
 
 #include "SDL.h"
 #include "SDL2/SDL_opengl.h"
@@ -24,6 +27,11 @@ enum TraitType {
 };
 
 
+//containers for traits, with their memory accounted to the traits category
+template <class V>
+using TraitMap = std::unordered_map<string, V, std::hash<string>, std::equal_to<string>,
+                                    TrackingAllocator<std::pair<const string, V>, TraitM>>;
+
 //box to hold traits which can be associated with a node or edge
 //each trait has a string label and a value, which may be one of several types
 //these traits are for data in the logical graph being represented
@@ -34,7 +42,12 @@ class TraitFrame {
         TraitFrame();
 
         //copy existing TraitFrame
-        TraitFrame(TraitFrame &old);
+        //copying is cheap -- containers are shared, and only duplicated when one copy is written to
+        //this makes it safe to read a copy from another thread while the original is edited
+        TraitFrame(const TraitFrame &old);
+        //share another frame's containers in place of this one's, in the same way
+        //counts as a change to this frame, so anything cached from its old traits is refreshed
+        TraitFrame &operator=(const TraitFrame &old);
 
         //temporary print function
         void tempPrint();
@@ -56,27 +69,61 @@ class TraitFrame {
         //if this is not NoneT, (*ret) is set to the address of the trait value
         //this allows both reading and updating of existing traits
         TraitType lookup(string label, void **ret);
+
+        //lookup a trait for reading only
+        //unlike lookup, this never copies shared containers or counts as a change
+        TraitType get(const string &label, const void **ret) const;
+
+        //returns a number which changes whenever the frame may have been written to
+        unsigned version() const;
         
         //function to write the traits to a given file
         void save(std::ofstream &f);
 
+        //function to append the traits, in the same format, to a buffer
+        void save(string &out) const;
+
+        //give this frame freshly allocated containers, with the same traits, whether shared or not
+        //used to move trait storage alongside a relocated node or edge -- not counted as a change
+        void relocate();
+
     private:
         //internal containers for traits
         //implementation may change -- public interface functions should not
-        std::unordered_map<string, int> traitInts;
-        std::unordered_map<string, double> traitDoubles;
-        std::unordered_map<string, string> traitStrings;
+        struct TraitData {
+            TraitMap<int> traitInts;
+            TraitMap<double> traitDoubles;
+            TraitMap<string> traitStrings;
+        };
+        std::shared_ptr<TraitData> data;
+        unsigned changes;
+
+        //give this frame its own containers, if they are shared with any copy
+        //must be called before any write
+        void detach();
 };
 
 //pre-declare -- help the compiler make pointers from node to edge
 class GraphEdge;
 
+//list of a node's edges, with its memory accounted to the edge-lists category
+typedef std::vector<GraphEdge *, TrackingAllocator<GraphEdge *, EdgeListM>> EdgeList;
+
 //class representing a node in a graph
 class GraphNode : public Drawable {
     public:
         GraphNode(double inX, double inY, string inLabel = "");
+        //relocating constructor -- a copy which takes over the old node's place in the graph
+        //every edge of the old node is pointed at the new one, and its statistics are moved over
+        //label, edge list and traits are copied into new storage, allocated alongside the new node
+        //the old node is left without edges, to be deleted without counting as a removal
+        explicit GraphNode(GraphNode *old);
         int onClick(double inX, double inY) override;
         void draw() override;
+        DrawableKind kind() override;
+
+        //function to append the node's definition to a buffer, in the format loadGraph reads
+        void save(string &out);
 
         ~GraphNode();
         
@@ -87,12 +134,28 @@ class GraphNode : public Drawable {
         //self-cycles are allowed -- this may create a link between a node and itself
         GraphEdge *link(GraphNode *g);
 
+        //function that creates a link to g, bundled into any existing edge between the two nodes
+        //if bundleEdges is not set, or there is no such edge, this creates one, as link() does
+        //returns the trait row of the new connection
+        //(*created) is set to the new edge, or to NULL if the connection was added to an existing one
+        TraitFrame *linkBundled(GraphNode *g, GraphEdge **created);
+
+        //function that returns a live edge between this node and g, or NULL if there is none
+        //cost is proportional to the smaller of the two nodes' lists of edges
+        GraphEdge *findEdge(GraphNode *g);
+
         //function that removes an edge from a node's list
         //this is called when an edge is marked for deletion, to prevent orphaned pointers
         void cut(GraphEdge *source);
+
+        //function that marks the node for deletion, along with every edge connected to it
+        void remove();
         
         //current drawing-position of the node in world-space
         double x, y;
+
+        //appearance, refreshed from style rules when they or the traits change
+        Style style;
         
         //identifier used for the node
         string label;
@@ -101,9 +164,23 @@ class GraphNode : public Drawable {
 
         static int totalNodes;
 
+        //whether parallel connections are bundled into a single edge, by linkBundled and file loading
+        static bool bundleEdges;
+
         //all edges connected to this node
-        std::vector<GraphEdge *> edges;
+        EdgeList edges;
+
+        //bookkeeping for the statistics in stats.h
+        //connections at this node, its connected component, and its slot in that component's list
+        int degree;
+        int component;
+        int componentSlot;
     private:
+        //set once another node has taken this one's place, or once it is unloaded
+        //the node is then deleted without logging or statistics
+        bool quiet;
+
+        friend void unloadNodes(const std::vector<GraphNode *> &nodes);
 };
 
 //class representing an edge in a graph
@@ -113,9 +190,18 @@ class GraphEdge : public Drawable {
         //this not only sets the nodes[] member of the edge
         //it additionally adds the new edge to the nodes' list of edges
         GraphEdge(GraphNode *n1, GraphNode *n2);
+        //relocating constructor -- a copy of the old edge, with its traits in new storage
+        //the nodes' edge lists still point at the old edge -- the caller must point them at the new one,
+        //which is done for many edges at once so that no list is searched once per edge
+        //the old edge is left to be deleted quietly
+        explicit GraphEdge(GraphEdge *old);
         ~GraphEdge();
         int onClick(double x, double y) override;
         void draw() override;
+        DrawableKind kind() override;
+
+        //function to append the edge's definition to a buffer, in the format loadGraph reads
+        void save(string &out);
 
         //function that returns the other end of an edge
         GraphNode *from(GraphNode *source);
@@ -129,11 +215,45 @@ class GraphEdge : public Drawable {
         //a cut happens at one end
         //dangling string is not desirable, so the other end is also cut, and the string falls.
 
+        //function that adds another connection to a bundled edge, returning its trait row
+        //source is the end the connection starts from, which is kept so the connection is saved as it was read
+        //the returned pointer is invalidated by the next call
+        TraitFrame *addRow(GraphNode *source);
+
+        //number of connections this edge stands for -- one, unless parallel connections were bundled
+        int count();
+
+        //ends of the i-th connection, in the direction it was made -- connection 0 is the edge itself
+        GraphNode *connectionFrom(int i);
+        GraphNode *connectionTo(int i);
+
+        //appearance, refreshed from style rules when they or the traits change
+        Style style;
+
+        //traits of the first connection
         TraitFrame traits;
+        //traits of every further connection between the same nodes, when bundled
+        std::vector<TraitFrame, TrackingAllocator<TraitFrame, TraitM>> rows;
+        //for each row, whether its connection goes from nodes[1] to nodes[0]
+        std::vector<char, TrackingAllocator<char, TraitM>> rowReversed;
         GraphNode *nodes[2];
     private:
+        //set once another edge has taken this one's place, or once it is cut by unloading a node
+        //the edge is then deleted without logging
+        bool quiet;
+
+        friend void unloadNodes(const std::vector<GraphNode *> &nodes);
 };
 
+//function to mark a group of nodes as expired, with every edge connected to them, as a single step
+//the statistics are updated once for the whole group, rather than once per node and edge
+//the registry owner then deletes them as usual, but without logging or statistics for each
+void unloadNodes(const std::vector<GraphNode *> &nodes);
+
+//function to delete every object of a graph at once, without logging or statistics for each
+//nothing outside the graph may point into it, and the statistics must be started over with statsReset
+void deleteGraph(std::vector<Drawable *> &graph);
+
 
 #endif
 
@@ -0,0 +1,421 @@
+#include "importer.h"
+#include "files.h"
+
+#include <charconv>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <string_view>
+
+#include <stdio.h>
+#include <string.h>
+
+using std::string_view;
+
+//hash for labels while importing
+//consumes eight bytes per step, rather than one byte per step as byte-wise hashes do
+struct LabelHash {
+    size_t operator()(string_view s) const {
+        const char *p = s.data();
+        size_t n = s.size();
+        unsigned long long h = 0x9E3779B97F4A7C15ULL ^ n;
+        unsigned long long k;
+        while(n >= 8) {
+            memcpy(&k, p, 8);
+            h = (h ^ k) * 0xBF58476D1CE4E5B9ULL;
+            h ^= h >> 31;
+            p += 8;
+            n -= 8;
+        }
+        k = 0;
+        memcpy(&k, p, n);
+        h = (h ^ k) * 0x94D049BB133111EBULL;
+        h ^= h >> 29;
+        return (size_t)h;
+    }
+};
+
+//every node seen by an import, deduplicated by label
+//labels are views into the file buffers, which must outlive the table
+struct LabelTable {
+    std::unordered_map<string_view, int, LabelHash> index;
+    std::vector<GraphNode *> nodes;
+
+    //returns the index of the node with the given label, creating it if it is new
+    int intern(string_view label) {
+        auto found = index.find(label);
+        if(found != index.end()) {
+            return found->second;
+        }
+        int i = nodes.size();
+        index.emplace(label, i);
+        nodes.push_back(new GraphNode(0, 0, string(label)));
+        return i;
+    }
+};
+
+//read an entire file into a buffer, returns false on failure
+static bool readWhole(string fileName, string &buf) {
+    std::error_code err;
+    auto size = std::filesystem::file_size(fileName, err);
+    FILE *f = fopen(fileName.c_str(), "rb");
+    if(err || !f) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Importer failed to open \"%s\".", fileName.c_str());
+        if(f) {
+            fclose(f);
+        }
+        return false;
+    }
+    buf.resize(size);
+    size_t got = fread(&buf[0], 1, size, f);
+    fclose(f);
+    buf.resize(got);
+    return true;
+}
+
+//split off the next line of a buffer, without its terminator
+//returns false once the buffer is exhausted
+static bool nextLine(const char *&p, const char *end, string_view &line) {
+    if(p >= end) {
+        return false;
+    }
+    //memchr is vectorized in common C libraries, so this scans many bytes per step
+    const char *nl = (const char *)memchr(p, '\n', end - p);
+    if(!nl) {
+        nl = end;
+    }
+    const char *e = nl;
+    if(e > p && e[-1] == '\r') {
+        e--;
+    }
+    line = string_view(p, e - p);
+    p = nl + 1;
+    return true;
+}
+
+static string_view trim(string_view s) {
+    while(!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while(!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+//split a CSV row into fields, appended to out
+//fields containing escaped quotes are unescaped into storage, which must outlive the fields
+static void splitCSV(string_view line, std::vector<string_view> &out, std::deque<string> &storage) {
+    const char *p = line.data();
+    const char *end = p + line.size();
+    if(!memchr(p, '"', line.size())) {
+        //common case -- no quoting, so fields are plain slices between commas
+        while(true) {
+            const char *comma = (const char *)memchr(p, ',', end - p);
+            if(!comma) {
+                out.push_back(trim(string_view(p, end - p)));
+                return;
+            }
+            out.push_back(trim(string_view(p, comma - p)));
+            p = comma + 1;
+        }
+    }
+
+    while(p <= end) {
+        while(p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+        if(p < end && *p == '"') {
+            p++;
+            const char *start = p;
+            bool escaped = false;
+            while(p < end && !(*p == '"' && !(p + 1 < end && p[1] == '"'))) {
+                if(*p == '"') {
+                    escaped = true;
+                    p++;
+                }
+                p++;
+            }
+            if(escaped) {
+                string s;
+                for(const char *c = start; c < p; c++) {
+                    s.push_back(*c);
+                    if(*c == '"') {
+                        c++;
+                    }
+                }
+                storage.push_back(s);
+                out.push_back(storage.back());
+            } else {
+                out.push_back(string_view(start, p - start));
+            }
+            //skip the closing quote, and anything up to the next comma
+            const char *comma = (const char *)memchr(p, ',', end - p);
+            p = comma ? comma + 1 : end + 1;
+        } else {
+            const char *comma = (const char *)memchr(p, ',', end - p);
+            if(!comma) {
+                comma = end;
+            }
+            out.push_back(trim(string_view(p, comma - p)));
+            p = comma + 1;
+        }
+    }
+}
+
+//add a single imported value as a trait, logging values which do not parse as their type
+static void addTrait(TraitFrame &traits, const string &label, TraitType type,
+                     string_view value, int line) {
+    if(value.empty()) {
+        //empty cells are missing data, rather than empty strings or zeroes
+        return;
+    }
+    const char *end = value.data() + value.size();
+    if(type == IntT) {
+        int v;
+        auto r = std::from_chars(value.data(), end, v);
+        if(r.ec != std::errc() || r.ptr != end) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Line %d: \"%s\" is not an Int.",
+                         line, string(value).c_str());
+            return;
+        }
+        traits.addInt(label, v);
+    } else if(type == DoubleT) {
+        double v;
+        auto r = std::from_chars(value.data(), end, v);
+        if(r.ec != std::errc() || r.ptr != end) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Line %d: \"%s\" is not a Double.",
+                         line, string(value).c_str());
+            return;
+        }
+        traits.addDouble(label, v);
+    } else {
+        traits.addString(label, string(value));
+    }
+}
+
+//create every edge in one pass, once all endpoints are known
+//each node's list of edges is sized up front, so no list is regrown while edges are added
+//fill, if given, is called with each connection's index and trait row as soon as it is made
+static void buildEdges(LabelTable &labels, std::vector<int> &ends, std::vector<GraphEdge *> &out,
+                       std::function<void(int, TraitFrame *)> fill = nullptr) {
+    if(GraphNode::bundleEdges) {
+        //lists only grow by distinct neighbors, so sizing them up front would overshoot
+        GraphEdge *e;
+        TraitFrame *row;
+        for(int i = 0; i + 1 < ends.size(); i += 2) {
+            row = labels.nodes[ends[i]]->linkBundled(labels.nodes[ends[i + 1]], &e);
+            if(e) {
+                out.push_back(e);
+            }
+            if(fill) {
+                fill(i / 2, row);
+            }
+        }
+        return;
+    }
+
+    std::vector<int> degree(labels.nodes.size(), 0);
+    for(int i = 0; i < ends.size(); i++) {
+        degree[ends[i]]++;
+    }
+    for(int i = 0; i < labels.nodes.size(); i++) {
+        labels.nodes[i]->edges.reserve(labels.nodes[i]->edges.size() + degree[i]);
+    }
+    out.reserve(ends.size() / 2);
+    for(int i = 0; i + 1 < ends.size(); i += 2) {
+        out.push_back(new GraphEdge(labels.nodes[ends[i]], labels.nodes[ends[i + 1]]));
+        if(fill) {
+            fill(i / 2, &(out.back()->traits));
+        }
+    }
+}
+
+//gather every node and edge into a single registry, and give the nodes positions
+static std::vector<Drawable *> finish(LabelTable &labels, std::vector<GraphEdge *> &edges) {
+    std::vector<Drawable *> ret;
+    ret.reserve(labels.nodes.size() + edges.size());
+    ret.insert(ret.end(), labels.nodes.begin(), labels.nodes.end());
+    ret.insert(ret.end(), edges.begin(), edges.end());
+    layoutCircle(labels.nodes);
+    SDL_Log("Imported %d nodes and %d edges.", (int)labels.nodes.size(), (int)edges.size());
+    return ret;
+}
+
+std::vector<Drawable *> importEdgeList(string fileName) {
+    LabelTable labels;
+    std::vector<GraphEdge *> edges;
+    string buf;
+    if(!readWhole(fileName, buf)) {
+        return std::vector<Drawable *>();
+    }
+
+    //endpoints of every edge, as consecutive pairs of node indices
+    std::vector<int> ends;
+    const char *p = buf.data();
+    const char *end = p + buf.size();
+    string_view line;
+    string_view ids[2];
+    int lineNumber = 0;
+    while(nextLine(p, end, line)) {
+        lineNumber++;
+        const char *c = line.data();
+        const char *lineEnd = c + line.size();
+        int found = 0;
+        while(found < 2) {
+            while(c < lineEnd && (*c == ' ' || *c == '\t')) {
+                c++;
+            }
+            if(c == lineEnd || (found == 0 && (*c == '#' || *c == '%'))) {
+                break;
+            }
+            const char *start = c;
+            while(c < lineEnd && *c != ' ' && *c != '\t') {
+                c++;
+            }
+            ids[found++] = string_view(start, c - start);
+        }
+        if(found == 1) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Line %d names only one node.", lineNumber);
+        }
+        if(found < 2) {
+            continue;
+        }
+        ends.push_back(labels.intern(ids[0]));
+        ends.push_back(labels.intern(ids[1]));
+    }
+
+    buildEdges(labels, ends, edges);
+    return finish(labels, edges);
+}
+
+std::vector<Drawable *> importCSV(string nodeFile, string edgeFile,
+                                  std::unordered_map<string, TraitType> types) {
+    LabelTable labels;
+    std::vector<GraphEdge *> edges;
+    string nodeBuf;
+    string edgeBuf;
+    std::deque<string> storage;
+    std::vector<string_view> fields;
+    std::vector<string> columns;
+    std::vector<TraitType> columnTypes;
+    string_view line;
+    int lineNumber;
+
+    if(nodeFile != "") {
+        if(!readWhole(nodeFile, nodeBuf)) {
+            return std::vector<Drawable *>();
+        }
+        const char *p = nodeBuf.data();
+        const char *end = p + nodeBuf.size();
+        lineNumber = 0;
+        while(nextLine(p, end, line)) {
+            lineNumber++;
+            if(trim(line).empty()) {
+                continue;
+            }
+            fields.clear();
+            splitCSV(line, fields, storage);
+            if(columns.empty()) {
+                //header row
+                for(int i = 0; i < fields.size(); i++) {
+                    columns.push_back(string(fields[i]));
+                    auto t = types.find(columns.back());
+                    columnTypes.push_back((t == types.end()) ? StringT : t->second);
+                }
+                continue;
+            }
+            int before = labels.nodes.size();
+            GraphNode *n = labels.nodes[labels.intern(fields[0])];
+            if(labels.nodes.size() == before) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Line %d: duplicate node label: \"%s\"",
+                             lineNumber, n->label.c_str());
+                continue;
+            }
+            for(int i = 1; i < fields.size() && i < columns.size(); i++) {
+                addTrait(n->traits, columns[i], columnTypes[i], fields[i], lineNumber);
+            }
+        }
+    }
+
+    if(edgeFile != "") {
+        if(!readWhole(edgeFile, edgeBuf)) {
+            return finish(labels, edges);
+        }
+        //edge traits are applied once the edges exist, so each row's fields are kept until then
+        std::vector<int> ends;
+        std::vector<string_view> rows;
+        std::vector<int> rowStarts;
+        std::vector<int> rowLines;
+        columns.clear();
+        columnTypes.clear();
+        const char *p = edgeBuf.data();
+        const char *end = p + edgeBuf.size();
+        lineNumber = 0;
+        while(nextLine(p, end, line)) {
+            lineNumber++;
+            if(trim(line).empty()) {
+                continue;
+            }
+            fields.clear();
+            splitCSV(line, fields, storage);
+            if(columns.empty()) {
+                for(int i = 0; i < fields.size(); i++) {
+                    columns.push_back(string(fields[i]));
+                    auto t = types.find(columns.back());
+                    columnTypes.push_back((t == types.end()) ? StringT : t->second);
+                }
+                continue;
+            }
+            if(fields.size() < 2) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Line %d names only one node.", lineNumber);
+                continue;
+            }
+            ends.push_back(labels.intern(fields[0]));
+            ends.push_back(labels.intern(fields[1]));
+            rowStarts.push_back(rows.size());
+            rowLines.push_back(lineNumber);
+            rows.insert(rows.end(), fields.begin() + 2, fields.end());
+        }
+        rowStarts.push_back(rows.size());
+
+        buildEdges(labels, ends, edges, [&](int e, TraitFrame *traits) {
+            for(int i = rowStarts[e]; i < rowStarts[e + 1] && i - rowStarts[e] + 2 < columns.size(); i++) {
+                int column = i - rowStarts[e] + 2;
+                addTrait(*traits, columns[column], columnTypes[column], rows[i], rowLines[e]);
+            }
+        });
+    }
+
+    return finish(labels, edges);
+}
+
+std::unordered_map<string, TraitType> parseColumnTypes(string spec) {
+    std::unordered_map<string, TraitType> ret;
+    size_t start = 0;
+    while(start < spec.size()) {
+        size_t comma = spec.find(',', start);
+        if(comma == string::npos) {
+            comma = spec.size();
+        }
+        string entry = spec.substr(start, comma - start);
+        size_t colon = entry.rfind(':');
+        if(colon == string::npos) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Column type \"%s\" has no type.", entry.c_str());
+        } else {
+            string type = entry.substr(colon + 1);
+            //type names match the keywords of graph files
+            if(type == "Int") {
+                ret[entry.substr(0, colon)] = IntT;
+            } else if(type == "Double") {
+                ret[entry.substr(0, colon)] = DoubleT;
+            } else if(type == "String") {
+                ret[entry.substr(0, colon)] = StringT;
+            } else {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unknown column type \"%s\".", type.c_str());
+            }
+        }
+        start = comma + 1;
+    }
+    return ret;
+}
@@ -0,0 +1,27 @@
+//defines importers for graph data stored in common external formats
+#ifndef IMPORTER_H
+#define IMPORTER_H
+
+#include "graphs.h"
+
+//function to read an edge list, in the style of the SNAP datasets
+//every line names an edge as two whitespace-separated node identifiers; further columns are ignored
+//lines beginning with '#' or '%' are comments
+//each distinct identifier becomes a node labeled with it
+//returns a vector containing every edge and node
+std::vector<Drawable *> importEdgeList(string fileName);
+
+//function to read a node table and an edge table in CSV format -- either file name may be empty
+//the first row of each table names its columns
+//the first column of the node table is the node label
+//the first two columns of the edge table are the labels of the edge's ends
+//every other column becomes a trait, typed by the types map -- unmapped columns are strings
+//nodes named only by the edge table are created without traits
+//returns a vector containing every edge and node
+std::vector<Drawable *> importCSV(string nodeFile, string edgeFile,
+                                  std::unordered_map<string, TraitType> types);
+
+//function to parse a column-type mapping of the form "Population:Int,Distance:Double,State:String"
+std::unordered_map<string, TraitType> parseColumnTypes(string spec);
+
+#endif
@@ -0,0 +1,276 @@
+//load generator for the query server -- sends random queries and reports latency and throughput
+//each connection keeps up to depth requests in flight, so pipelining is exercised as well as concurrency
+#include "protocol.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using std::string;
+typedef std::chrono::steady_clock Clock;
+
+//bytes read from the socket per call
+#define READ_CHUNK (65536)
+
+//most labels fetched from the server to query against
+#define LABEL_LIMIT (100000)
+
+//begin globals
+string socketPath = "";
+int requests = 100000;
+int depth = 16;
+int connections = 4;
+int batch = 1;
+uint8_t op = TraitQ;
+string trait = "Population";
+std::vector<string> labels;
+std::atomic<long long> errors(0);
+//end globals
+
+//open a connection to the server
+//returns the socket, or -1 on error
+static int connectServer() {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    if(fd < 0 || connect(fd, (sockaddr *)&address, sizeof(address))) {
+        fprintf(stderr, "Failed to connect to \"%s\": %s\n", socketPath.c_str(), strerror(errno));
+        if(fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+//returns nonzero iff error
+static int sendAll(int fd, const string &buf) {
+    size_t sent = 0;
+    while(sent < buf.size()) {
+        ssize_t n = write(fd, buf.data() + sent, buf.size() - sent);
+        if(n <= 0) {
+            return 1;
+        }
+        sent += n;
+    }
+    return 0;
+}
+
+//buffered reader of whole frames from a socket
+struct FrameReader {
+    int fd;
+    string in;
+    size_t used = 0;
+
+    //wait for the next frame, pointing frame at everything after its length
+    //returns false if the connection closed first
+    bool next(const char **frame, uint32_t *length) {
+        while(true) {
+            if(in.size() - used >= sizeof(uint32_t)) {
+                memcpy(length, &in[used], sizeof(uint32_t));
+                if(in.size() - used - sizeof(uint32_t) >= *length) {
+                    *frame = &in[used + sizeof(uint32_t)];
+                    used += sizeof(uint32_t) + *length;
+                    return true;
+                }
+            }
+            //drop consumed frames before reading more, so the buffer does not grow without bound
+            in.erase(0, used);
+            used = 0;
+            size_t have = in.size();
+            in.resize(have + READ_CHUNK);
+            ssize_t got = read(fd, &in[have], READ_CHUNK);
+            if(got <= 0) {
+                return false;
+            }
+            in.resize(have + got);
+        }
+    }
+};
+
+//append the body of one query on a random label to out
+static void appendQuery(MessageWriter &out, std::mt19937 &rng) {
+    out.str(labels[rng() % labels.size()]);
+    if(op == TraitQ) {
+        out.str(trait);
+    }
+}
+
+//issue count requests over one connection, recording the latency of each in microseconds
+static void worker(int count, unsigned seed, std::vector<double> &latencies) {
+    int fd = connectServer();
+    if(fd < 0) {
+        errors += count;
+        return;
+    }
+    FrameReader reader;
+    reader.fd = fd;
+    std::mt19937 rng(seed);
+    std::vector<Clock::time_point> sent(count);
+    latencies.reserve(count);
+
+    int issued = 0;
+    int done = 0;
+    MessageWriter out;
+    while(done < count) {
+        //top the pipeline back up, sending every new request in one write
+        while(issued < count && issued - done < depth) {
+            size_t start;
+            if(batch > 1) {
+                start = out.beginFrame(issued, BatchQ);
+                out.u32(batch);
+                for(int i = 0; i < batch; i++) {
+                    out.u8(op);
+                    appendQuery(out, rng);
+                }
+            } else {
+                start = out.beginFrame(issued, op);
+                appendQuery(out, rng);
+            }
+            out.endFrame(start);
+            sent[issued] = Clock::now();
+            issued++;
+        }
+        if(out.buf.size()) {
+            if(sendAll(fd, out.buf)) {
+                break;
+            }
+            out.buf.clear();
+        }
+
+        const char *frame;
+        uint32_t length;
+        if(!reader.next(&frame, &length)) {
+            break;
+        }
+        MessageReader response(frame, length);
+        uint32_t id = response.u32();
+        uint8_t status = response.u8();
+        if(!response.ok || id >= count || status != QueryOk) {
+            errors++;
+        } else {
+            latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent[id]).count());
+        }
+        done++;
+    }
+    errors += count - done;
+    close(fd);
+}
+
+//returns nonzero iff error
+static int fetchLabels() {
+    int fd = connectServer();
+    if(fd < 0) {
+        return 1;
+    }
+    MessageWriter out;
+    size_t start = out.beginFrame(0, LabelsQ);
+    out.u32(LABEL_LIMIT);
+    out.endFrame(start);
+    FrameReader reader;
+    reader.fd = fd;
+    const char *frame;
+    uint32_t length;
+    if(sendAll(fd, out.buf) || !reader.next(&frame, &length)) {
+        close(fd);
+        fprintf(stderr, "Server closed the connection.\n");
+        return 1;
+    }
+    close(fd);
+
+    MessageReader response(frame, length);
+    response.u32();
+    if(response.u8() != QueryOk) {
+        fprintf(stderr, "Labels request failed: %s\n", response.str().c_str());
+        return 1;
+    }
+    uint32_t count = response.u32();
+    for(uint32_t i = 0; i < count && response.ok; i++) {
+        labels.push_back(response.str());
+    }
+    if(labels.empty()) {
+        fprintf(stderr, "Server has no nodes to query.\n");
+        return 1;
+    }
+    return 0;
+}
+
+static double percentile(const std::vector<double> &sorted, double p) {
+    size_t i = (size_t)(p * sorted.size());
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+int main(int argc, char **argv) {
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "--requests" && hasValue) {
+            requests = atoi(argv[++i]);
+        } else if(arg == "--depth" && hasValue) {
+            depth = atoi(argv[++i]);
+        } else if(arg == "--connections" && hasValue) {
+            connections = atoi(argv[++i]);
+        } else if(arg == "--batch" && hasValue) {
+            batch = atoi(argv[++i]);
+        } else if(arg == "--trait" && hasValue) {
+            trait = argv[++i];
+        } else if(arg == "--op" && hasValue) {
+            string name = argv[++i];
+            op = (name == "neighbors") ? NeighborsQ : TraitQ;
+        } else {
+            socketPath = arg;
+        }
+    }
+    if(socketPath == "" || requests < 1 || depth < 1 || connections < 1 || batch < 1) {
+        fprintf(stderr, "Usage: loadgen <socket path> [--requests N] [--depth D] [--connections C]\n"
+                        "               [--batch B] [--op trait|neighbors] [--trait label]\n");
+        return 1;
+    }
+    if(fetchLabels()) {
+        return 1;
+    }
+
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for(int i = 0; i < connections; i++) {
+        int count = requests / connections + (i < requests % connections);
+        threads.emplace_back(worker, count, 1234 + i, std::ref(latencies[i]));
+    }
+    for(int i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> all;
+    for(int i = 0; i < latencies.size(); i++) {
+        all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+    }
+    if(all.empty()) {
+        fprintf(stderr, "No requests completed.\n");
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+
+    //a batch counts once toward latency, but each query in it counts toward throughput
+    printf("%d connections, depth %d, batch %d, %s queries on %d labels\n", connections, depth, batch,
+           (op == NeighborsQ) ? "neighbors" : "trait", (int)labels.size());
+    printf("Requests: %zu completed, %lld failed, in %.3lf s\n", all.size(), (long long)errors, seconds);
+    printf("QPS: %.0lf\n", all.size() * batch / seconds);
+    printf("Latency (us): p50 %.1lf  p90 %.1lf  p99 %.1lf  p99.9 %.1lf  max %.1lf\n",
+           percentile(all, 0.5), percentile(all, 0.9), percentile(all, 0.99), percentile(all, 0.999),
+           all.back());
+    return errors > 0;
+}
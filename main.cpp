@@ -2,14 +2,35 @@
 #define SDL_MAIN_HANDLED
 #include "graphs.h"
 #include "files.h"
+#include "tiles.h"
+#include "importer.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "styles.h"
+#include "focus.h"
+#include "expressions.h"
+#include "replay.h"
+#include "reorder.h"
 
 //gluUnProject is used currently, other utilities may be later.
 #include <GL/GLU.h>
+#include <stdlib.h>
+#include <math.h>
 
 //constants for basic 2d camera movement
 #define MOVE_STEP (0.05)
 #define ZOOM_STEP (1.1)
 
+//defaults for tiled graphs
+#define TILE_SIZE (50.0)
+//megabytes of graph objects kept resident
+#define TILE_BUDGET (256)
+
+//time between autosaves of an edited graph, in milliseconds
+#define AUTOSAVE_INTERVAL (60000)
+//longest a replay waits for the window to take on a recorded size, in milliseconds
+#define REPLAY_RESIZE_WAIT (1000)
+
 
 //function to initialize the display, returns nonzero iff error
 static int initializeDisplay();
@@ -20,18 +41,45 @@ static int mainLoop();
 //function to refresh the display
 static void updateDisplay();
 
+//pass one event to every handler, setting (*redraw) if the display needs refreshing
+//returns zero if the event should end the program
+static int handleEvent(SDL_Event e, int *redraw);
+
 //check if an event is a click on an object, return nonzero if so
 static int checkClicks(SDL_Event);
 //process events which resize the display, return nonzero if this event did
 static int checkResize(SDL_Event);
 //process events which move the camera, return nonzero if this event did
 static int checkMotion(SDL_Event);
+//process events which toggle overlays or run commands, return nonzero if this event did
+static int checkHotkeys(SDL_Event);
 //determine whether this event should end the program
 static int checkQuits(SDL_Event);
 
 //convenience function to translate display pixels to world coordinates
 static void screenToWorld(double *x, double *y);
 
+//read the graph named on the command line, from whichever format it was given in
+//returns an empty graph if none was named
+static std::vector<Drawable *> readInput();
+
+//page tiles in and out to cover the current view, given the latest camera motion
+static void pageTiles(double dx, double dy);
+
+//the objects which can currently be seen and clicked -- the focused neighborhood, if there is one
+static const std::vector<Drawable *> &visible();
+//point the camera at the focused neighborhood, zoomed out far enough to see all of it
+static void fitFocus();
+
+//compile and run a statement given on the command line, logging what it did
+//returns nonzero iff error
+static int runStatement(string source, DrawableKind kind, int filter);
+
+//log a full memory report, after measuring the parts of memory which are not tracked as they change
+static void reportMemory();
+//refresh the window title with the text of the active overlay
+static void updateOverlay();
+
 //these functions are all static to limit visibility
 //they should not need to be used outside of this file
 //as such, confine to this translation unit, just as a default
@@ -51,14 +99,130 @@ double scaleFactor = 10.0;
 
 //all current drawables 
 std::vector<Drawable *> objects;
+
+//resident part of a tiled graph, if one is open
+TileCache tiles;
+
+//input files named on the command line
+string graphFile = "";
+string edgeListFile = "";
+string csvNodeFile = "";
+string csvEdgeFile = "";
+string columnTypes = "";
+
+//whether the memory and statistics overlays are shown in the window title
+int memoryOverlay = 0;
+int statsOverlay = 0;
+
+//node clicked first, waiting for a second click to link it
+GraphNode *selected = NULL;
+
+//neighborhood being focused on, if any
+FocusView focus;
+//whether objects may have expired since the registry was last swept
+//while focused, only the view is drawn, so the registry is swept only when this is set
+int purgeNeeded = 1;
+
+//recording of the events handled, or playback of one in place of live input
+EventRecorder recorder;
+EventPlayer player;
+//whether playback waits for each batch's recorded time, rather than running as fast as possible
+int replayRealTime = 1;
+//time taken to draw each frame
+FrameTimer frameTimer;
+
+//background saving, and whether the graph has been edited since it was last saved
+SnapshotSaver saver;
+int unsavedEdits = 0;
 //end globals
 
 int main(int argc, char **argv) {
+    string tileDir = "";
+    string tileOutput = "";
+    int tileBudget = TILE_BUDGET;
+    int memReport = 0;
+    string styleFile = "";
+    //statements to run once the graph is read, in order, with the kind of object each runs over
+    //a kind of OtherK marks a filter over nodes, which only reports its matches
+    std::vector<std::pair<string, DrawableKind>> statements;
+    string recordFile = "";
+    string replayFile = "";
+    string frameTimeFile = "";
+    string reorderName = "";
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if(arg == "--build-tiles" && i + 1 < argc) {
+            //split the graph file into tiles, then exit without opening a display
+            tileOutput = argv[++i];
+        } else if(arg == "--tiles" && i + 1 < argc) {
+            tileDir = argv[++i];
+        } else if(arg == "--tile-budget" && i + 1 < argc) {
+            //in megabytes
+            tileBudget = atoi(argv[++i]);
+        } else if(arg == "--edge-list" && i + 1 < argc) {
+            edgeListFile = argv[++i];
+        } else if(arg == "--csv-nodes" && i + 1 < argc) {
+            csvNodeFile = argv[++i];
+        } else if(arg == "--csv-edges" && i + 1 < argc) {
+            csvEdgeFile = argv[++i];
+        } else if(arg == "--column-types" && i + 1 < argc) {
+            columnTypes = argv[++i];
+        } else if(arg == "--bundle-edges") {
+            //store parallel edges as a single edge with several trait rows
+            GraphNode::bundleEdges = true;
+        } else if(arg == "--styles" && i + 1 < argc) {
+            styleFile = argv[++i];
+        } else if(arg == "--compute" && i + 1 < argc) {
+            statements.push_back(std::make_pair(string(argv[++i]), NodeK));
+        } else if(arg == "--compute-edges" && i + 1 < argc) {
+            statements.push_back(std::make_pair(string(argv[++i]), EdgeK));
+        } else if(arg == "--filter" && i + 1 < argc) {
+            statements.push_back(std::make_pair(string(argv[++i]), OtherK));
+        } else if(arg == "--record" && i + 1 < argc) {
+            recordFile = argv[++i];
+        } else if(arg == "--replay" && i + 1 < argc) {
+            replayFile = argv[++i];
+        } else if(arg == "--replay-fast") {
+            //play back without waiting between batches, and without waiting for vertical sync
+            replayRealTime = 0;
+        } else if(arg == "--frame-times" && i + 1 < argc) {
+            frameTimeFile = argv[++i];
+        } else if(arg == "--reorder" && i + 1 < argc) {
+            //store the graph in hilbert or rcm order once it is read
+            reorderName = argv[++i];
+        } else if(arg == "--mem-report") {
+            //report memory use once the graph is read, and again at exit
+            memReport = 1;
+        } else {
+            graphFile = arg;
+        }
+    }
+
+    if(tileOutput != "") {
+        if(graphFile != "" && edgeListFile == "" && csvNodeFile == "" && csvEdgeFile == "") {
+            //graph files are streamed, so they can be split without fitting in memory
+            return buildTilesFromFile(graphFile, tileOutput, TILE_SIZE);
+        }
+        std::vector<Drawable *> graph = readInput();
+        if(graph.empty()) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "--build-tiles requires a graph to split.");
+            return 1;
+        }
+        if(memReport) { reportMemory(); }
+        return buildTiles(graph, tileOutput, TILE_SIZE);
+    }
+
+    Ordering ordering = HilbertO;
+    if(reorderName != "" && parseOrdering(reorderName, &ordering)) { return 1; }
+
     if(initializeDisplay()) { return 1; }
 
-    if(argc > 1) {
+    if(tileDir != "") {
+        if(tiles.open(tileDir, tileBudget * (1LL << 20))) { return 1; }
+        pageTiles(0, 0);
+    } else if(graphFile != "" || edgeListFile != "" || csvNodeFile != "" || csvEdgeFile != "") {
         //read in specified file
-        objects = loadGraph(argv[1]);
+        objects = readInput();
 
     } else {
         //simple hardcoded graph to test basics
@@ -75,9 +239,56 @@ int main(int argc, char **argv) {
         objects.push_back(((GraphNode *)objects[1])->link((GraphNode *)objects[5]));
     }
 
+    if(reorderName != "") {
+        if(tiles.isOpen()) {
+            SDL_Log("Reordering is not supported while browsing a tiled graph.");
+        } else {
+            reorderGraph(objects, ordering);
+        }
+    }
+
+    //computed traits are in place before styles read them
+    for(int i = 0; i < statements.size(); i++) {
+        DrawableKind kind = statements[i].second;
+        if(runStatement(statements[i].first, (kind == OtherK) ? NodeK : kind, kind == OtherK)) {
+            return 1;
+        }
+    }
+
+    if(styleFile != "" && !loadStyles(styleFile)) {
+        applyStyles(objects);
+    }
+
+    if(memReport) { reportMemory(); }
+
+    //times are measured from here, once the graph is ready
+    if(replayFile != "") {
+        if(player.open(replayFile)) { return 1; }
+        if(!replayRealTime) {
+            SDL_GL_SetSwapInterval(0);
+        }
+    } else if(recordFile != "" && recorder.open(recordFile)) {
+        return 1;
+    }
+
     while(mainLoop()) {}
 
-    saveGraph(objects, "outputGraph.txt");
+    recorder.close();
+    if(player.isOpen() || frameTimeFile != "") {
+        SDL_Log("Frame times: %s", frameTimer.report().c_str());
+    }
+    if(frameTimeFile != "") {
+        frameTimer.save(frameTimeFile);
+    }
+
+    if(memReport) { reportMemory(); }
+
+    //a tiled graph only has part of itself in memory -- saving that part would be misleading
+    //a replay must not overwrite the output of the session it replays, or of the latest real one
+    saver.wait();
+    if(!tiles.isOpen() && !player.isOpen()) {
+        saveGraph(objects, "outputGraph.txt");
+    }
     
     SDL_GL_DeleteContext(context);
     SDL_Quit();
@@ -87,23 +298,109 @@ int main(int argc, char **argv) {
 static int mainLoop() {
     static SDL_Event e;
     static int redraw = 1;
+    static Uint32 lastSave = SDL_GetTicks();
+    //events handled in one pass are drawn as one frame -- recordings keep that grouping
+    static int batch = 0;
+    //batch being replayed, and the next of its events to handle
+    static std::vector<RecordedEvent> due;
+    static int dueNext = 0;
+    //set while a replay waits for the window to take on a recorded size, and when it asked for it
+    static int resizePending = 0;
+    static Uint32 resizeAsked = 0;
 
     if(redraw) {
+        frameTimer.begin();
         updateDisplay();
+        if(player.isOpen()) {
+            //wait for the frame to be finished, so its time is the time to draw it
+            glFinish();
+        }
+        frameTimer.end();
         redraw = 0;
     }
 
-    while(SDL_PollEvent(&e)) {
-
-        if(checkClicks(e)) { redraw = 1; }
+    if(player.isOpen()) {
+        //live input is ignored while replaying, other than closing the window
+        //and the window reporting that it has taken on a recorded size
+        while(SDL_PollEvent(&e)) {
+            if(checkQuits(e)) { return 0; }
+            if(resizePending && e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                resizePending = 0;
+                handleEvent(e, &redraw);
+            }
+        }
+        if(resizePending && SDL_GetTicks() - resizeAsked > REPLAY_RESIZE_WAIT) {
+            SDL_Log("Window did not take on the recorded size -- replaying on regardless.");
+            resizePending = 0;
+            handleEvent(due[dueNext - 1].event, &redraw);
+        }
+        if(resizePending) {
+            return 1;
+        }
+        if(dueNext >= due.size()) {
+            if(player.finished()) {
+                return 0;
+            }
+            if(player.nextBatch(replayRealTime, due)) {
+                dueNext = 0;
+            }
+        }
+        while(dueNext < due.size()) {
+            RecordedEvent &r = due[dueNext++];
+            //handlers read modifiers from the keyboard state, so it is put back as recorded
+            SDL_SetModState((SDL_Keymod)r.mod);
+            if(r.event.type == SDL_WINDOWEVENT) {
+                //resizing is asynchronous -- the rest of the recording waits until the window has the recorded size,
+                //so clicks after it land in the same viewport as they did when recorded
+                int w;
+                int h;
+                SDL_GetWindowSize(window, &w, &h);
+                if(w != r.event.window.data1 || h != r.event.window.data2) {
+                    SDL_SetWindowSize(window, r.event.window.data1, r.event.window.data2);
+                    resizePending = 1;
+                    resizeAsked = SDL_GetTicks();
+                    break;
+                }
+            }
+            if(!handleEvent(r.event, &redraw)) { return 0; }
+        }
+    } else {
+        int handled = 0;
+        while(SDL_PollEvent(&e)) {
+            recorder.record(e, batch);
+            handled = 1;
+            if(!handleEvent(e, &redraw)) { return 0; }
+        }
+        batch += handled;
+    }
 
-        if(checkResize(e)) { redraw = 1; }
+    //the snapshot is taken here, and written out on another thread while editing continues
+    //replays edit the graph as the recorded session did, but never save over the user's files
+    if(unsavedEdits && !tiles.isOpen() && !player.isOpen() && SDL_GetTicks() - lastSave > AUTOSAVE_INTERVAL) {
+        if(saver.save(objects, "autosave.txt")) {
+            unsavedEdits = 0;
+            lastSave = SDL_GetTicks();
+        }
+    }
 
-        if(checkMotion(e)) { redraw = 1; }
+    return 1;
+}
 
-        if(checkQuits(e)) { return 0; }
+static int handleEvent(SDL_Event e, int *redraw) {
+    if(checkClicks(e)) {
+        *redraw = 1;
+        unsavedEdits = 1;
+        purgeNeeded = 1;
     }
 
+    if(checkResize(e)) { *redraw = 1; }
+
+    if(checkMotion(e)) { *redraw = 1; }
+
+    if(checkHotkeys(e)) { *redraw = 1; }
+
+    if(checkQuits(e)) { return 0; }
+
     return 1;
 }
 
@@ -154,53 +451,80 @@ static void updateDisplay() {
     
     glClear(GL_COLOR_BUFFER_BIT);
     
+    int drawAll = !focus.isActive();
     int i = 0;
-    while(i < objects.size()) {
+    while((drawAll || purgeNeeded) && i < objects.size()) {
         if(objects[i]->getState() == ExpiredS) {
             //order of objects need not be preserved
             //accelerate removal via pulling the last thing to the should-be-empty spot
             //using a list-based structure would allow constant-time deletion and order-preservation
+            if(tiles.isOpen()) {
+                tiles.release(objects[i]);
+            }
+            focus.release(objects[i]);
+            if(objects[i] == selected) {
+                selected = NULL;
+            }
             delete objects[i];
             objects[i] = objects.back();
             //objects[objects.size() - 1] = temp;
             objects.pop_back();
         } else {
-            objects[i]->draw();
+            if(drawAll) {
+                objects[i]->draw();
+            }
             i++;
         }
     }
+    purgeNeeded = 0;
+
+    //drawing the focused neighborhood costs nothing for the rest of the graph
+    if(!drawAll) {
+        const std::vector<Drawable *> &view = focus.members();
+        for(i = 0; i < view.size(); i++) {
+            view[i]->draw();
+        }
+    }
 
     //ensure the drawing is actually made visible.
     glFlush();
     SDL_GL_SwapWindow(window);
+
+    updateOverlay();
 }
 
 static int checkClicks(SDL_Event e) {
-    static GraphNode *n1 = NULL;
     static GraphNode *n2 = NULL;
     if((e.type == SDL_MOUSEBUTTONDOWN)) {
         double x = e.button.x;
         double y = e.button.y;
         screenToWorld(&x, &y);
         
+        //while focused, only the neighborhood can be clicked
+        const std::vector<Drawable *> &clickable = visible();
         int i;
-        for(i = 0; i < objects.size(); i++) {
-            if(objects[i]->onClick(x, y)) {
-                if(objects[i]->getState() == ExpiredS) {
+        for(i = 0; i < clickable.size(); i++) {
+            if(clickable[i]->onClick(x, y)) {
+                if(clickable[i]->getState() == ExpiredS) {
                     //object is now marked for deletion -- will be removed from the drawable registry
                 } else {
                     //if clicking on two nodes in a row, link them
-                    if(n1) {
-                        n2 = dynamic_cast<GraphNode *>(objects[i]);
+                    if(selected) {
+                        n2 = dynamic_cast<GraphNode *>(clickable[i]);
                         if(n2) {
-                            objects.push_back(n1->link(n2));
-                            n1->resetState();
+                            GraphEdge *created;
+                            selected->linkBundled(n2, &created);
+                            if(created) {
+                                objects.push_back(created);
+                                focus.add(created);
+                            }
+                            selected->resetState();
                             n2->resetState();
-                            n1 = NULL;
+                            selected = NULL;
                             n2 = NULL;
                         }
                     } else {
-                        n1 = dynamic_cast<GraphNode *>(objects[i]);
+                        selected = dynamic_cast<GraphNode *>(clickable[i]);
                     }
                 }
                 
@@ -209,18 +533,20 @@ static int checkClicks(SDL_Event e) {
         }
 
         //clicked nowhere -- deactivate and potentially move any clicked node
-        if(n1) {
-            n1->resetState();
+        if(selected) {
+            selected->resetState();
             if(SDL_GetModState() & KMOD_CTRL) {
-                n1->x = x;
-                n1->y = y;
+                selected->x = x;
+                selected->y = y;
+                focus.moved(selected);
             }
-            n1 = NULL;
+            selected = NULL;
             return 1;
         } else {
             //create a node, if Ctrl active.
             if(SDL_GetModState() & KMOD_CTRL) {
                 objects.push_back(new GraphNode(x, y));
+                focus.add(objects.back());
                 return 1;
             }
 
@@ -235,13 +561,17 @@ static int checkClicks(SDL_Event e) {
 static int checkResize(SDL_Event e) {
     if((e.type == SDL_WINDOWEVENT) && (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)) {
         SDL_GL_GetDrawableSize(window, &width, &height);
+        pageTiles(0, 0);
         return 1;
     }
     return 0;
 }
 
 static int checkMotion(SDL_Event e) {
-    if(e.type == SDL_KEYDOWN) {
+    double oldX = centerX;
+    double oldY = centerY;
+    //keys held with ctrl are commands, rather than camera motion
+    if(e.type == SDL_KEYDOWN && !(e.key.keysym.mod & KMOD_CTRL)) {
         switch(e.key.keysym.sym) {
             case SDLK_w:
             case SDLK_UP:
@@ -271,6 +601,83 @@ static int checkMotion(SDL_Event e) {
                 return 0;
                 break;
         }
+        pageTiles(centerX - oldX, centerY - oldY);
+        return 1;
+    }
+    return 0;
+}
+
+static int checkHotkeys(SDL_Event e) {
+    if(e.type == SDL_KEYDOWN) {
+        switch(e.key.keysym.sym) {
+            case SDLK_m:
+                memoryOverlay = !memoryOverlay;
+                if(memoryOverlay) {
+                    reportMemory();
+                }
+                break;
+            case SDLK_i:
+                statsOverlay = !statsOverlay;
+                if(statsOverlay) {
+                    SDL_Log("Graph statistics:\n%s", statsReport().c_str());
+                }
+                break;
+            case SDLK_f:
+                //focus on the selected node, or leave focus if nothing is selected
+                if(selected) {
+                    focus.focus(selected, 1);
+                    selected->resetState();
+                    selected = NULL;
+                    fitFocus();
+                } else if(focus.isActive()) {
+                    focus.clear();
+                    SDL_Log("Left focus.");
+                } else {
+                    SDL_Log("Select a node to focus on.");
+                }
+                break;
+            case SDLK_RIGHTBRACKET:
+            case SDLK_LEFTBRACKET:
+                if(!focus.isActive()) {
+                    return 0;
+                }
+                focus.setRadius(focus.radius() + ((e.key.keysym.sym == SDLK_RIGHTBRACKET) ? 1 : -1));
+                fitFocus();
+                break;
+            case SDLK_h:
+            case SDLK_r:
+                //restore locality after edits, by moving the graph into fresh storage in a new order
+                if(tiles.isOpen()) {
+                    SDL_Log("Reordering is not supported while browsing a tiled graph.");
+                    break;
+                }
+                //nothing may keep pointing at the old storage
+                focus.clear();
+                if(selected) {
+                    selected->resetState();
+                    selected = NULL;
+                }
+                reorderGraph(objects, (e.key.keysym.sym == SDLK_h) ? HilbertO : CuthillMcKeeO);
+                purgeNeeded = 1;
+                break;
+            case SDLK_s:
+                if(!(e.key.keysym.mod & KMOD_CTRL)) {
+                    return 0;
+                }
+                if(tiles.isOpen()) {
+                    SDL_Log("Saving is not supported while browsing a tiled graph.");
+                } else if(player.isOpen()) {
+                    SDL_Log("Saving is skipped while replaying.");
+                } else if(saver.save(objects, "outputGraph.txt")) {
+                    unsavedEdits = 0;
+                } else {
+                    SDL_Log("Previous save still in progress.");
+                }
+                break;
+            default:
+                return 0;
+                break;
+        }
         return 1;
     }
     return 0;
@@ -300,3 +707,95 @@ static void screenToWorld(double *x, double *y) {
 
     gluUnProject(*x, *y, z, model, proj, view, x, y, &z);
 }
+
+static std::vector<Drawable *> readInput() {
+    if(edgeListFile != "") {
+        return importEdgeList(edgeListFile);
+    } else if(csvNodeFile != "" || csvEdgeFile != "") {
+        return importCSV(csvNodeFile, csvEdgeFile, parseColumnTypes(columnTypes));
+    } else if(graphFile != "") {
+        return loadGraph(graphFile);
+    }
+    return std::vector<Drawable *>();
+}
+
+static void pageTiles(double dx, double dy) {
+    if(!tiles.isOpen()) {
+        return;
+    }
+    //evicted tiles leave expired objects behind
+    purgeNeeded = 1;
+    //matches the projection set up in updateDisplay
+    double aspectRatio = ((double) width) / height;
+    tiles.update(centerX - (aspectRatio * scaleFactor), centerY - scaleFactor,
+                 centerX + (aspectRatio * scaleFactor), centerY + scaleFactor,
+                 dx, dy, objects);
+}
+
+static const std::vector<Drawable *> &visible() {
+    return focus.isActive() ? focus.members() : objects;
+}
+
+static void fitFocus() {
+    if(!focus.isActive()) {
+        return;
+    }
+    double oldX = centerX;
+    double oldY = centerY;
+    centerX = focus.center()->x;
+    centerY = focus.center()->y;
+    scaleFactor = fmax(10.0, 1.2 * focus.extent());
+    SDL_Log("Focus radius %d: %d objects in view.", focus.radius(), (int)focus.members().size());
+    pageTiles(centerX - oldX, centerY - oldY);
+}
+
+static int runStatement(string source, DrawableKind kind, int filter) {
+    Expression e;
+    if(e.compile(source, objects, kind)) {
+        return 1;
+    }
+    if(filter == e.isAssignment()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "\"%s\" is %s.", source.c_str(),
+                     filter ? "an assignment, not a filter" : "a condition, not an assignment");
+        return 1;
+    }
+    std::vector<Drawable *> matches;
+    Uint32 start = SDL_GetTicks();
+    long long count = e.run(objects, &matches);
+    Uint32 took = SDL_GetTicks() - start;
+    if(!filter) {
+        SDL_Log("\"%s\" assigned %lld rows in %u ms.", source.c_str(), count, took);
+        return 0;
+    }
+    SDL_Log("\"%s\" matched %lld nodes in %u ms.", source.c_str(), count, took);
+    for(int i = 0; i < matches.size() && i < 10; i++) {
+        SDL_Log("    %s", static_cast<GraphNode *>(matches[i])->label.c_str());
+    }
+    if(matches.size() > 10) {
+        SDL_Log("    ...");
+    }
+    return 0;
+}
+
+static void reportMemory() {
+    //the registry changes too often, in too many places, to track as it goes
+    memorySet(RegistryM, objects.capacity() * sizeof(Drawable *), objects.capacity() ? 1 : 0);
+    SDL_Log("Memory report:\n%s", memoryReport().c_str());
+}
+
+static void updateOverlay() {
+    //no text rendering is available yet, so overlays are shown in the window title
+    static string shown = "";
+    string title = "GraphViewer";
+    if(memoryOverlay) {
+        memorySet(RegistryM, objects.capacity() * sizeof(Drawable *), objects.capacity() ? 1 : 0);
+        title += " -- " + memorySummary();
+    }
+    if(statsOverlay) {
+        title += " -- " + statsSummary();
+    }
+    if(title != shown) {
+        SDL_SetWindowTitle(window, title.c_str());
+        shown = title;
+    }
+}
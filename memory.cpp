@@ -0,0 +1,110 @@
+#include "memory.h"
+
+#include <stdio.h>
+
+//typical bookkeeping cost of a heap block in common allocators
+//used to estimate overhead which cannot be measured portably
+#define BLOCK_OVERHEAD (16)
+
+static MemoryCounter counters[MemoryCategories];
+//every category together -- its peak is the true high-water mark, which the category peaks need not sum to
+static MemoryCounter total;
+
+static const char *categoryNames[MemoryCategories] = {
+    "Traits",
+    "Labels",
+    "Edge lists",
+    "Nodes",
+    "Edges",
+    "Registry"
+};
+
+static void raisePeak(MemoryCounter &m, long long now) {
+    long long peak = m.peak.load(std::memory_order_relaxed);
+    while(now > peak && !m.peak.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {}
+}
+
+void memoryAdd(MemoryCategory c, long long bytes) {
+    MemoryCounter &m = counters[c];
+    m.allocations.fetch_add(1, std::memory_order_relaxed);
+    raisePeak(m, m.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    total.allocations.fetch_add(1, std::memory_order_relaxed);
+    raisePeak(total, total.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void memoryRemove(MemoryCategory c, long long bytes) {
+    MemoryCounter &m = counters[c];
+    m.allocations.fetch_sub(1, std::memory_order_relaxed);
+    m.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    total.allocations.fetch_sub(1, std::memory_order_relaxed);
+    total.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void memorySet(MemoryCategory c, long long bytes, long long allocations) {
+    MemoryCounter &m = counters[c];
+    long long oldAllocations = m.allocations.exchange(allocations, std::memory_order_relaxed);
+    long long oldBytes = m.bytes.exchange(bytes, std::memory_order_relaxed);
+    raisePeak(m, bytes);
+    total.allocations.fetch_add(allocations - oldAllocations, std::memory_order_relaxed);
+    raisePeak(total, total.bytes.fetch_add(bytes - oldBytes, std::memory_order_relaxed) + bytes - oldBytes);
+}
+
+const MemoryCounter &memoryUsage(MemoryCategory c) {
+    return counters[c];
+}
+
+const MemoryCounter &memoryTotal() {
+    return total;
+}
+
+//format a byte count with a binary unit
+static std::string formatBytes(double bytes) {
+    const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    int unit = 0;
+    while(bytes >= 1024 && unit < 4) {
+        bytes /= 1024;
+        unit++;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.1lf %s", bytes, units[unit]);
+    return buf;
+}
+
+std::string memoryReport() {
+    long long nodes = counters[NodeM].allocations.load(std::memory_order_relaxed);
+    long long edges = counters[EdgeM].allocations.load(std::memory_order_relaxed);
+    //what each category's average is taken over
+    long long per[MemoryCategories] = {nodes + edges, nodes, nodes, nodes, edges, nodes + edges};
+
+    std::string ret;
+    char line[160];
+    snprintf(line, sizeof(line), "%-12s %12s %12s %12s %12s\n",
+             "Category", "Current", "Peak", "Blocks", "Per object");
+    ret += line;
+    for(int c = 0; c < MemoryCategories; c++) {
+        long long bytes = counters[c].bytes.load(std::memory_order_relaxed);
+        long long count = counters[c].allocations.load(std::memory_order_relaxed);
+        snprintf(line, sizeof(line), "%-12s %12s %12s %12lld %12s\n", categoryNames[c],
+                 formatBytes(bytes).c_str(),
+                 formatBytes(counters[c].peak.load(std::memory_order_relaxed)).c_str(),
+                 count, per[c] ? formatBytes((double)bytes / per[c]).c_str() : "-");
+        ret += line;
+    }
+    long long blocks = total.allocations.load(std::memory_order_relaxed);
+    snprintf(line, sizeof(line), "%-12s %12s %12s %12lld\n", "Overhead",
+             formatBytes(blocks * BLOCK_OVERHEAD).c_str(), "-", blocks);
+    ret += line;
+    //overhead is an estimate, so it is kept out of the total
+    snprintf(line, sizeof(line), "%-12s %12s %12s\n", "Total",
+             formatBytes(total.bytes.load(std::memory_order_relaxed)).c_str(),
+             formatBytes(total.peak.load(std::memory_order_relaxed)).c_str());
+    ret += line;
+    //trait strings allocate through the plain string allocator, so are not seen by any category
+    ret += "Not counted: heap storage of trait names and string values too long to fit inside the string.\n";
+    return ret;
+}
+
+std::string memorySummary() {
+    return "Memory: " + formatBytes(total.bytes.load(std::memory_order_relaxed)) + " in use, " +
+           formatBytes(total.peak.load(std::memory_order_relaxed)) + " peak";
+}
@@ -0,0 +1,82 @@
+//defines accounting of memory use, divided by the subsystem using it
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <atomic>
+#include <string>
+#include <stddef.h>
+
+//identifiers for the subsystems memory is accounted to
+enum MemoryCategory {
+    TraitM,
+    LabelM,
+    EdgeListM,
+    NodeM,
+    EdgeM,
+    RegistryM,
+    //number of categories -- not a category itself
+    MemoryCategories
+};
+
+//usage of a single category
+//allocations counts live blocks -- for NodeM and EdgeM, this is the number of live objects
+struct MemoryCounter {
+    std::atomic<long long> bytes;
+    std::atomic<long long> peak;
+    std::atomic<long long> allocations;
+};
+
+//record memory taken by, or returned from, a category
+void memoryAdd(MemoryCategory c, long long bytes);
+void memoryRemove(MemoryCategory c, long long bytes);
+
+//set a category's usage outright, for memory which is measured when reporting rather than tracked
+void memorySet(MemoryCategory c, long long bytes, long long allocations);
+
+//returns the current counter for a category
+const MemoryCounter &memoryUsage(MemoryCategory c);
+
+//returns the counter for every category together
+//its peak is the highest total reached at any one moment
+const MemoryCounter &memoryTotal();
+
+//returns a multi-line table of every category: current and peak bytes, allocations, per-object average
+//heap storage of trait strings is not tracked, and is listed as excluded
+std::string memoryReport();
+
+//returns a single line with total current and peak use, short enough for a window title
+std::string memorySummary();
+
+//allocator which accounts everything it allocates to a category
+//used for containers inside graph objects, so their growth is visible without walking the graph
+template <class T, MemoryCategory C>
+struct TrackingAllocator {
+    typedef T value_type;
+
+    //explicit, as the category parameter prevents automatic rebinding
+    template <class U>
+    struct rebind {
+        typedef TrackingAllocator<U, C> other;
+    };
+
+    TrackingAllocator() {}
+    template <class U>
+    TrackingAllocator(const TrackingAllocator<U, C> &) {}
+
+    T *allocate(size_t n) {
+        memoryAdd(C, n * sizeof(T));
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n) {
+        memoryRemove(C, n * sizeof(T));
+        ::operator delete(p);
+    }
+
+    template <class U>
+    bool operator==(const TrackingAllocator<U, C> &) const { return true; }
+    template <class U>
+    bool operator!=(const TrackingAllocator<U, C> &) const { return false; }
+};
+
+#endif
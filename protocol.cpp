@@ -0,0 +1,101 @@
+#include "protocol.h"
+
+#include <string.h>
+
+void MessageWriter::u8(uint8_t v) {
+    buf.push_back((char)v);
+}
+
+void MessageWriter::u32(uint32_t v) {
+    buf.append((const char *)&v, sizeof(v));
+}
+
+void MessageWriter::u64(uint64_t v) {
+    buf.append((const char *)&v, sizeof(v));
+}
+
+void MessageWriter::i32(int32_t v) {
+    buf.append((const char *)&v, sizeof(v));
+}
+
+void MessageWriter::f64(double v) {
+    buf.append((const char *)&v, sizeof(v));
+}
+
+void MessageWriter::str(const std::string &v) {
+    u32(v.size());
+    buf += v;
+}
+
+size_t MessageWriter::beginFrame(uint32_t id, uint8_t code) {
+    size_t start = buf.size();
+    //length is filled in by endFrame
+    u32(0);
+    u32(id);
+    u8(code);
+    return start;
+}
+
+void MessageWriter::endFrame(size_t start) {
+    uint32_t length = buf.size() - start - sizeof(uint32_t);
+    memcpy(&buf[start], &length, sizeof(length));
+}
+
+
+MessageReader::MessageReader(const char *data, size_t size) {
+    p = data;
+    end = data + size;
+    ok = true;
+}
+
+bool MessageReader::take(void *out, size_t n) {
+    if(!ok || end - p < n) {
+        ok = false;
+        memset(out, 0, n);
+        return false;
+    }
+    memcpy(out, p, n);
+    p += n;
+    return true;
+}
+
+uint8_t MessageReader::u8() {
+    uint8_t v;
+    take(&v, sizeof(v));
+    return v;
+}
+
+uint32_t MessageReader::u32() {
+    uint32_t v;
+    take(&v, sizeof(v));
+    return v;
+}
+
+uint64_t MessageReader::u64() {
+    uint64_t v;
+    take(&v, sizeof(v));
+    return v;
+}
+
+int32_t MessageReader::i32() {
+    int32_t v;
+    take(&v, sizeof(v));
+    return v;
+}
+
+double MessageReader::f64() {
+    double v;
+    take(&v, sizeof(v));
+    return v;
+}
+
+std::string MessageReader::str() {
+    uint32_t n = u32();
+    if(!ok || end - p < n) {
+        ok = false;
+        return "";
+    }
+    std::string v(p, n);
+    p += n;
+    return v;
+}
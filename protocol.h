@@ -0,0 +1,85 @@
+//defines the binary protocol spoken over the query server's socket
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <string>
+#include <stdint.h>
+
+//every message is a frame: u32 length of the rest of the frame, u32 request id, u8 code, then a body
+//requests carry an operation code, responses a status code. ids are echoed back unchanged
+//requests on one connection may be pipelined -- responses come back in the order requests were sent
+//integers are in host byte order, as both ends of a local socket share it
+//strings are a u32 length followed by their bytes
+
+//identifiers for request operations
+enum QueryOp : uint8_t {
+    //body: path. replaces the graph with the one in the file
+    LoadQ = 1,
+    //body: path. saves a snapshot of the graph
+    SaveQ,
+    //body: node label, trait label. response: u8 TraitType, then an i32, f64 or string if found
+    TraitQ,
+    //body: node label. response: u32 count, then the label at the other end of each edge
+    NeighborsQ,
+    //body: node label, trait label, u8 TraitType, value. inserts or updates a trait
+    SetTraitQ,
+    //response: u64 nodes, u64 edges, u64 connected components
+    StatsQ,
+    //body: u32 limit. response: u32 count, then up to limit node labels
+    LabelsQ,
+    //body: u32 count, then count sub-requests of u8 operation and body
+    //response: u32 count, then count sub-responses of u8 status and body
+    BatchQ
+};
+
+//identifiers for response status
+//an error's body is a string describing it
+enum QueryStatus : uint8_t {
+    QueryOk = 0,
+    QueryError
+};
+
+//size of the length, id and code at the start of every frame
+#define FRAME_HEADER (9)
+
+//appends values to a message
+class MessageWriter {
+    public:
+        std::string buf;
+
+        void u8(uint8_t v);
+        void u32(uint32_t v);
+        void u64(uint64_t v);
+        void i32(int32_t v);
+        void f64(double v);
+        void str(const std::string &v);
+
+        //start a frame, returning its offset in buf -- endFrame must be called once its body is written
+        size_t beginFrame(uint32_t id, uint8_t code);
+        void endFrame(size_t start);
+};
+
+//reads values from a message
+//reading past the end yields zeroes and clears ok, rather than failing at each call
+class MessageReader {
+    public:
+        MessageReader(const char *data, size_t size);
+
+        uint8_t u8();
+        uint32_t u32();
+        uint64_t u64();
+        int32_t i32();
+        double f64();
+        std::string str();
+
+        bool ok;
+
+    private:
+        //copy n bytes out of the message, if they are there
+        bool take(void *out, size_t n);
+
+        const char *p;
+        const char *end;
+};
+
+#endif
@@ -0,0 +1,204 @@
+#include "reorder.h"
+
+#include <algorithm>
+
+//side of the grid positions are snapped to before following the Hilbert curve
+#define HILBERT_SIDE (65536)
+
+int parseOrdering(string name, Ordering *out) {
+    if(name == "hilbert") {
+        *out = HilbertO;
+    } else if(name == "rcm") {
+        *out = CuthillMcKeeO;
+    } else {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unknown ordering \"%s\" -- expected hilbert or rcm.",
+                     name.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+//distance along a Hilbert curve filling a side-by-side grid, side a power of two
+static unsigned long long hilbertIndex(unsigned x, unsigned y, unsigned side) {
+    unsigned long long d = 0;
+    for(unsigned s = side / 2; s > 0; s /= 2) {
+        unsigned rx = (x & s) > 0;
+        unsigned ry = (y & s) > 0;
+        d += (unsigned long long)s * s * ((3 * rx) ^ ry);
+        //rotate the quadrant, so the curve inside it joins up with its neighbors
+        if(ry == 0) {
+            if(rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+static void hilbertOrder(std::vector<GraphNode *> &nodes) {
+    if(nodes.empty()) {
+        return;
+    }
+    double minX = nodes[0]->x;
+    double maxX = nodes[0]->x;
+    double minY = nodes[0]->y;
+    double maxY = nodes[0]->y;
+    for(int i = 1; i < nodes.size(); i++) {
+        minX = std::min(minX, nodes[i]->x);
+        maxX = std::max(maxX, nodes[i]->x);
+        minY = std::min(minY, nodes[i]->y);
+        maxY = std::max(maxY, nodes[i]->y);
+    }
+    //one scale for both axes, so the curve's locality is the same in every direction
+    double span = std::max(maxX - minX, maxY - minY);
+    double scale = (span > 0) ? (HILBERT_SIDE - 1) / span : 0;
+
+    std::vector<std::pair<unsigned long long, GraphNode *>> keyed(nodes.size());
+    for(int i = 0; i < nodes.size(); i++) {
+        unsigned x = (unsigned)((nodes[i]->x - minX) * scale);
+        unsigned y = (unsigned)((nodes[i]->y - minY) * scale);
+        keyed[i] = std::make_pair(hilbertIndex(x, y, HILBERT_SIDE), nodes[i]);
+    }
+    std::stable_sort(keyed.begin(), keyed.end(),
+                     [](const std::pair<unsigned long long, GraphNode *> &a,
+                        const std::pair<unsigned long long, GraphNode *> &b) { return a.first < b.first; });
+    for(int i = 0; i < nodes.size(); i++) {
+        nodes[i] = keyed[i].second;
+    }
+}
+
+static void cuthillMcKeeOrder(std::vector<GraphNode *> &nodes) {
+    std::unordered_map<GraphNode *, int> index;
+    index.reserve(nodes.size());
+    for(int i = 0; i < nodes.size(); i++) {
+        index[nodes[i]] = i;
+    }
+    auto byDegree = [](GraphNode *a, GraphNode *b) { return a->edges.size() < b->edges.size(); };
+
+    //each component is searched from a node of least degree, which tends to lie on its edge
+    std::vector<GraphNode *> starts = nodes;
+    std::stable_sort(starts.begin(), starts.end(), byDegree);
+
+    std::vector<char> visited(nodes.size(), 0);
+    std::vector<GraphNode *> order;
+    order.reserve(nodes.size());
+    std::vector<GraphNode *> found;
+    for(int s = 0; s < starts.size(); s++) {
+        if(visited[index[starts[s]]]) {
+            continue;
+        }
+        visited[index[starts[s]]] = 1;
+        //the order itself serves as the search's queue
+        int head = order.size();
+        order.push_back(starts[s]);
+        while(head < order.size()) {
+            GraphNode *n = order[head++];
+            found.clear();
+            for(int i = 0; i < n->edges.size(); i++) {
+                GraphNode *m = n->edges[i]->from(n);
+                auto at = index.find(m);
+                if(at != index.end() && !visited[at->second]) {
+                    visited[at->second] = 1;
+                    found.push_back(m);
+                }
+            }
+            std::stable_sort(found.begin(), found.end(), byDegree);
+            order.insert(order.end(), found.begin(), found.end());
+        }
+    }
+    //reversing keeps the same bandwidth, but packs the profile more tightly
+    std::reverse(order.begin(), order.end());
+    nodes.swap(order);
+}
+
+void reorderGraph(std::vector<Drawable *> &graph, Ordering order) {
+    Uint32 start = SDL_GetTicks();
+    std::vector<GraphNode *> nodes;
+    std::vector<GraphEdge *> edges;
+    std::vector<Drawable *> rest;
+    for(int i = 0; i < graph.size(); i++) {
+        if(graph[i]->getState() == ExpiredS) {
+            rest.push_back(graph[i]);
+        } else if(graph[i]->kind() == NodeK) {
+            nodes.push_back(static_cast<GraphNode *>(graph[i]));
+        } else if(graph[i]->kind() == EdgeK) {
+            edges.push_back(static_cast<GraphEdge *>(graph[i]));
+        } else {
+            rest.push_back(graph[i]);
+        }
+    }
+
+    if(order == HilbertO) {
+        hilbertOrder(nodes);
+    } else {
+        cuthillMcKeeOrder(nodes);
+    }
+
+    //edges follow the earlier of their ends, then the later, so each lies near the nodes it joins
+    std::unordered_map<GraphNode *, int> rank;
+    rank.reserve(nodes.size());
+    for(int i = 0; i < nodes.size(); i++) {
+        rank[nodes[i]] = i;
+    }
+    std::vector<std::pair<std::pair<int, int>, GraphEdge *>> keyed(edges.size());
+    for(int i = 0; i < edges.size(); i++) {
+        int a = rank[edges[i]->nodes[0]];
+        int b = rank[edges[i]->nodes[1]];
+        keyed[i] = std::make_pair(std::make_pair(std::min(a, b), std::max(a, b)), edges[i]);
+    }
+    std::sort(keyed.begin(), keyed.end(),
+              [](const std::pair<std::pair<int, int>, GraphEdge *> &a,
+                 const std::pair<std::pair<int, int>, GraphEdge *> &b) { return a.first < b.first; });
+
+    //everything new is allocated before anything old is freed
+    //so the allocator hands out fresh, consecutive memory, rather than refilling the old holes
+    std::vector<Drawable *> moved;
+    moved.reserve(graph.size());
+    for(int i = 0; i < nodes.size(); i++) {
+        moved.push_back(new GraphNode(nodes[i]));
+    }
+    for(int i = 0; i < keyed.size(); i++) {
+        moved.push_back(new GraphEdge(keyed[i].second));
+    }
+
+    //every edge list is pointed at the new edges in one pass, rather than searched once per edge
+    std::unordered_map<GraphEdge *, GraphEdge *> movedEdges;
+    movedEdges.reserve(edges.size());
+    for(int i = 0; i < keyed.size(); i++) {
+        movedEdges[keyed[i].second] = static_cast<GraphEdge *>(moved[nodes.size() + i]);
+    }
+    for(int i = 0; i < nodes.size(); i++) {
+        EdgeList &list = static_cast<GraphNode *>(moved[i])->edges;
+        for(int j = 0; j < list.size(); j++) {
+            auto m = movedEdges.find(list[j]);
+            if(m != movedEdges.end()) {
+                list[j] = m->second;
+            }
+        }
+    }
+
+    //each node's edges are visited in storage order too
+    for(int i = 0; i < nodes.size(); i++) {
+        rank[static_cast<GraphNode *>(moved[i])] = i;
+    }
+    for(int i = 0; i < nodes.size(); i++) {
+        GraphNode *n = static_cast<GraphNode *>(moved[i]);
+        std::stable_sort(n->edges.begin(), n->edges.end(), [&](GraphEdge *a, GraphEdge *b) {
+            return rank[a->from(n)] < rank[b->from(n)];
+        });
+    }
+
+    for(int i = 0; i < nodes.size(); i++) {
+        delete nodes[i];
+    }
+    for(int i = 0; i < edges.size(); i++) {
+        delete edges[i];
+    }
+    moved.insert(moved.end(), rest.begin(), rest.end());
+    graph.swap(moved);
+
+    SDL_Log("Reordered %d nodes and %d edges by %s in %u ms.", (int)nodes.size(), (int)edges.size(),
+            (order == HilbertO) ? "Hilbert curve" : "reverse Cuthill-McKee", SDL_GetTicks() - start);
+}
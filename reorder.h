@@ -0,0 +1,27 @@
+//defines passes which renumber a graph's storage, so that related nodes are stored near each other
+#ifndef REORDER_H
+#define REORDER_H
+
+#include "graphs.h"
+
+//identifiers for orders a graph can be stored in
+enum Ordering {
+    //along a Hilbert curve over node positions -- nodes near each other on screen are near in memory
+    HilbertO,
+    //reverse Cuthill-McKee over adjacency -- neighbors are near in memory
+    CuthillMcKeeO
+};
+
+//function to read the name of an ordering, "hilbert" or "rcm"
+//returns nonzero iff the name is not known
+int parseOrdering(string name, Ordering *out);
+
+//function to store a graph in a new order
+//every live node, then every live edge, is moved into storage allocated in the new order,
+//along with its label, edge list and traits
+//edges are ordered by the nodes they join, each node's edges are sorted by their other end,
+//and the registry is rewritten in the same order
+//anything else pointing at nodes or edges -- tiles, focus, selections -- must be let go of first
+void reorderGraph(std::vector<Drawable *> &graph, Ordering order);
+
+#endif
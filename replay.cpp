@@ -0,0 +1,193 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include <string.h>
+
+//each line of a recording is
+//  batch ticks mod Click x y button
+//  batch ticks mod Key sym
+//  batch ticks mod Resize width height
+//  batch ticks mod Quit
+
+EventRecorder::EventRecorder() {
+    start = 0;
+}
+
+int EventRecorder::open(string fileName) {
+    f.open(fileName);
+    if(f.fail()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open \"%s\" for recording.", fileName.c_str());
+        return 1;
+    }
+    start = SDL_GetTicks();
+    SDL_Log("Recording events to \"%s\".", fileName.c_str());
+    return 0;
+}
+
+bool EventRecorder::isOpen() {
+    return f.is_open();
+}
+
+void EventRecorder::record(const SDL_Event &e, int batch) {
+    if(!isOpen()) {
+        return;
+    }
+    //handlers read modifiers from the keyboard state, not the event, so that is what is kept
+    Uint16 mod = (e.type == SDL_KEYDOWN) ? e.key.keysym.mod : (Uint16)SDL_GetModState();
+    string prefix = std::to_string(batch) + " " + std::to_string(SDL_GetTicks() - start) + " " +
+                    std::to_string(mod) + " ";
+    switch(e.type) {
+        case SDL_MOUSEBUTTONDOWN:
+            f << prefix << "Click " << e.button.x << " " << e.button.y << " " << (int)e.button.button << "\n";
+            break;
+        case SDL_KEYDOWN:
+            f << prefix << "Key " << e.key.keysym.sym << "\n";
+            break;
+        case SDL_WINDOWEVENT:
+            if(e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                f << prefix << "Resize " << e.window.data1 << " " << e.window.data2 << "\n";
+            }
+            break;
+        case SDL_QUIT:
+            f << prefix << "Quit\n";
+            break;
+        default:
+            break;
+    }
+}
+
+void EventRecorder::close() {
+    if(isOpen()) {
+        f.close();
+    }
+}
+
+
+EventPlayer::EventPlayer() {
+    opened = false;
+    next = 0;
+    start = 0;
+}
+
+int EventPlayer::open(string fileName) {
+    std::ifstream f;
+    f.open(fileName);
+    if(f.fail()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open recording \"%s\".", fileName.c_str());
+        return 1;
+    }
+
+    string line;
+    int lineNumber = 0;
+    while(std::getline(f, line)) {
+        lineNumber++;
+        if(line == "") {
+            continue;
+        }
+        std::istringstream in(line);
+        RecordedEvent r;
+        string type;
+        memset(&r.event, 0, sizeof(r.event));
+        in >> r.batch >> r.ticks >> r.mod >> type;
+        if(type == "Click") {
+            int button;
+            r.event.type = SDL_MOUSEBUTTONDOWN;
+            in >> r.event.button.x >> r.event.button.y >> button;
+            r.event.button.button = button;
+        } else if(type == "Key") {
+            r.event.type = SDL_KEYDOWN;
+            in >> r.event.key.keysym.sym;
+            r.event.key.keysym.mod = r.mod;
+        } else if(type == "Resize") {
+            r.event.type = SDL_WINDOWEVENT;
+            r.event.window.event = SDL_WINDOWEVENT_SIZE_CHANGED;
+            in >> r.event.window.data1 >> r.event.window.data2;
+        } else if(type == "Quit") {
+            r.event.type = SDL_QUIT;
+        } else {
+            in.setstate(std::ios::failbit);
+        }
+        if(in.fail()) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Recording \"%s\" is malformed at line %d.",
+                         fileName.c_str(), lineNumber);
+            events.clear();
+            return 1;
+        }
+        events.push_back(r);
+    }
+    f.close();
+
+    next = 0;
+    opened = true;
+    start = SDL_GetTicks();
+    SDL_Log("Replaying %d events from \"%s\".", (int)events.size(), fileName.c_str());
+    return 0;
+}
+
+bool EventPlayer::isOpen() {
+    return opened;
+}
+
+bool EventPlayer::finished() {
+    return next >= events.size();
+}
+
+bool EventPlayer::nextBatch(bool realTime, std::vector<RecordedEvent> &out) {
+    out.clear();
+    if(finished() || (realTime && SDL_GetTicks() - start < events[next].ticks)) {
+        return false;
+    }
+    int batch = events[next].batch;
+    while(next < events.size() && events[next].batch == batch) {
+        out.push_back(events[next++]);
+    }
+    return true;
+}
+
+
+FrameTimer::FrameTimer() {
+    started = 0;
+}
+
+void FrameTimer::begin() {
+    started = SDL_GetPerformanceCounter();
+}
+
+void FrameTimer::end() {
+    times.push_back((SDL_GetPerformanceCounter() - started) * 1000.0 / SDL_GetPerformanceFrequency());
+}
+
+string FrameTimer::report() {
+    if(times.empty()) {
+        return "No frames drawn.";
+    }
+    std::vector<double> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for(int i = 0; i < sorted.size(); i++) {
+        total += sorted[i];
+    }
+    auto at = [&](double p) {
+        return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+    };
+    char line[256];
+    snprintf(line, sizeof(line), "%d frames, mean %.3lf ms, p50 %.3lf, p90 %.3lf, p99 %.3lf, max %.3lf",
+             (int)sorted.size(), total / sorted.size(), at(0.5), at(0.9), at(0.99), sorted.back());
+    return line;
+}
+
+int FrameTimer::save(string fileName) {
+    std::ofstream f;
+    f.open(fileName);
+    if(f.fail()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open \"%s\" for frame times.", fileName.c_str());
+        return 1;
+    }
+    for(int i = 0; i < times.size(); i++) {
+        f << times[i] << "\n";
+    }
+    f.close();
+    return 0;
+}
@@ -0,0 +1,96 @@
+//defines recording of the events a session handles, playing them back, and timing each frame
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "SDL.h"
+
+using std::string;
+
+//an event as it was handled, with what is needed to handle it the same way again
+struct RecordedEvent {
+    //events handled in the same pass of the main loop share a batch, and are drawn as one frame
+    int batch;
+    //milliseconds since recording started
+    Uint32 ticks;
+    //modifier keys held, which handlers read from SDL_GetModState rather than from the event
+    Uint16 mod;
+    SDL_Event event;
+};
+
+//writes the events a session handles to a file, one per line
+//only events some handler acts on are kept -- clicks, key presses, resizes and quitting
+class EventRecorder {
+    public:
+        EventRecorder();
+
+        //start recording to a file -- times are measured from this call
+        //returns nonzero iff error
+        int open(string fileName);
+
+        //returns true iff recording
+        bool isOpen();
+
+        //record one event, about to be handled in the given batch
+        void record(const SDL_Event &e, int batch);
+
+        //finish writing the recording
+        void close();
+
+    private:
+        std::ofstream f;
+        Uint32 start;
+};
+
+//feeds a recording back, batch by batch
+class EventPlayer {
+    public:
+        EventPlayer();
+
+        //read a whole recording -- times are measured from this call
+        //returns nonzero iff error
+        int open(string fileName);
+
+        //returns true iff a recording is being played
+        bool isOpen();
+
+        //returns true once every batch has been played
+        bool finished();
+
+        //fill out with the next batch, if it is due
+        //in real time a batch is due once as long has passed as when it was recorded, otherwise at once
+        //returns true iff a batch was given
+        bool nextBatch(bool realTime, std::vector<RecordedEvent> &out);
+
+    private:
+        std::vector<RecordedEvent> events;
+        int next;
+        bool opened;
+        Uint32 start;
+};
+
+//collects the time taken to draw each frame
+class FrameTimer {
+    public:
+        FrameTimer();
+
+        //call around each redraw
+        void begin();
+        void end();
+
+        //count, mean and percentiles of the frame times so far
+        string report();
+
+        //write every frame time, in milliseconds, one per line -- for comparing runs
+        //returns nonzero iff error
+        int save(string fileName);
+
+    private:
+        std::vector<double> times;
+        Uint64 started;
+};
+
+#endif
@@ -0,0 +1,391 @@
+//headless query server -- serves the graph core over a Unix domain socket, without any display
+//each connection is served by its own thread, which answers reads directly under a shared lock
+//operations which change the graph are handed to a single writer thread, which runs them one at a time
+#define SDL_MAIN_HANDLED
+#include "graphs.h"
+#include "files.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "protocol.h"
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+//bytes read from a connection per call
+#define READ_CHUNK (65536)
+
+//serve one connection until it closes
+static void serveConnection(int fd);
+
+//answer a single operation, appending its response body to out
+//returns the response status
+static uint8_t handle(uint8_t op, MessageReader &in, MessageWriter &out);
+
+//run a change to the graph on the writer thread, and wait for it to finish
+//returns what the change returned
+static int submitWrite(std::function<int()> change);
+
+//loop run by the writer thread
+static void writerLoop();
+
+//replace the graph with one read from a file
+//the file is read in full on the calling thread, while the old graph is still served, so a failed load changes nothing
+//only swapping the new graph in is handed to the writer thread
+//returns nonzero iff error
+static int replaceGraph(string fileName);
+
+//begin globals
+//the graph being served, and every node in it by label
+std::vector<Drawable *> objects;
+std::unordered_map<string, GraphNode *> labels;
+
+//readers share this lock, and the writer thread holds it alone
+std::shared_mutex graphLock;
+
+//changes waiting for the writer thread
+std::deque<std::packaged_task<int()>> writes;
+std::mutex writesLock;
+std::condition_variable writesReady;
+
+//held while a new graph is read, so loads are read one at a time
+std::mutex loadLock;
+//end globals
+
+int main(int argc, char **argv) {
+    string socketPath = "";
+    string graphFile = "";
+    for(int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if(arg == "--bundle-edges") {
+            GraphNode::bundleEdges = true;
+        } else if(socketPath == "") {
+            socketPath = arg;
+        } else {
+            graphFile = arg;
+        }
+    }
+    if(socketPath == "") {
+        SDL_Log("Usage: server <socket path> [graph file] [--bundle-edges]");
+        return 1;
+    }
+
+    std::thread(writerLoop).detach();
+    if(graphFile != "" && replaceGraph(graphFile)) {
+        return 1;
+    }
+
+    //a client disconnecting mid-response should end that connection, not the server
+    signal(SIGPIPE, SIG_IGN);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(socketPath.size() >= sizeof(address.sun_path)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Socket path is too long.");
+        return 1;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+    unlink(socketPath.c_str());
+    if(listener < 0 || bind(listener, (sockaddr *)&address, sizeof(address)) || listen(listener, 64)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to listen on \"%s\": %s",
+                     socketPath.c_str(), strerror(errno));
+        return 1;
+    }
+    SDL_Log("Serving on \"%s\".", socketPath.c_str());
+
+    while(true) {
+        int fd = accept(listener, NULL, NULL);
+        if(fd < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "accept failed: %s", strerror(errno));
+            break;
+        }
+        std::thread(serveConnection, fd).detach();
+    }
+    close(listener);
+    return 1;
+}
+
+static void serveConnection(int fd) {
+    string in;
+    MessageWriter out;
+    size_t used = 0;
+    while(true) {
+        //read whatever has arrived -- several pipelined requests may come in at once
+        size_t have = in.size();
+        in.resize(have + READ_CHUNK);
+        ssize_t got = read(fd, &in[have], READ_CHUNK);
+        if(got <= 0) {
+            break;
+        }
+        in.resize(have + got);
+
+        //answer every complete frame, collecting the responses to send together
+        while(in.size() - used >= sizeof(uint32_t)) {
+            uint32_t length;
+            memcpy(&length, &in[used], sizeof(length));
+            if(in.size() - used - sizeof(uint32_t) < length) {
+                break;
+            }
+            MessageReader frame(&in[used + sizeof(uint32_t)], length);
+            uint32_t id = frame.u32();
+            uint8_t op = frame.u8();
+            size_t start = out.beginFrame(id, QueryOk);
+            out.buf[start + FRAME_HEADER - 1] = handle(op, frame, out);
+            out.endFrame(start);
+            used += sizeof(uint32_t) + length;
+        }
+        in.erase(0, used);
+        used = 0;
+
+        size_t sent = 0;
+        while(sent < out.buf.size()) {
+            ssize_t n = write(fd, out.buf.data() + sent, out.buf.size() - sent);
+            if(n <= 0) {
+                close(fd);
+                return;
+            }
+            sent += n;
+        }
+        out.buf.clear();
+    }
+    close(fd);
+}
+
+//replace anything written so far for a response with an error message
+static uint8_t fail(MessageWriter &out, size_t bodyStart, string message) {
+    out.buf.resize(bodyStart);
+    out.str(message);
+    return QueryError;
+}
+
+static uint8_t handle(uint8_t op, MessageReader &in, MessageWriter &out) {
+    size_t bodyStart = out.buf.size();
+    switch(op) {
+        case LoadQ: {
+            string path = in.str();
+            if(!in.ok) {
+                return fail(out, bodyStart, "Malformed request.");
+            }
+            if(replaceGraph(path)) {
+                return fail(out, bodyStart, "Load failed.");
+            }
+            return QueryOk;
+        }
+        case SaveQ: {
+            string path = in.str();
+            if(!in.ok) {
+                return fail(out, bodyStart, "Malformed request.");
+            }
+            //only taking the snapshot needs the lock -- writing it out does not block the writer
+            std::shared_ptr<GraphSnapshot> snapshot;
+            {
+                std::shared_lock<std::shared_mutex> guard(graphLock);
+                snapshot = takeSnapshot(objects);
+            }
+            if(saveSnapshot(*snapshot, path)) {
+                return fail(out, bodyStart, "Save failed.");
+            }
+            return QueryOk;
+        }
+        case TraitQ: {
+            string node = in.str();
+            string trait = in.str();
+            if(!in.ok) {
+                return fail(out, bodyStart, "Malformed request.");
+            }
+            std::shared_lock<std::shared_mutex> guard(graphLock);
+            auto n = labels.find(node);
+            if(n == labels.end()) {
+                return fail(out, bodyStart, "No node labeled \"" + node + "\".");
+            }
+            const void *p;
+            TraitType type = n->second->traits.get(trait, &p);
+            out.u8(type);
+            if(type == IntT) {
+                out.i32(*(const int *)p);
+            } else if(type == DoubleT) {
+                out.f64(*(const double *)p);
+            } else if(type == StringT) {
+                out.str(*(const string *)p);
+            }
+            return QueryOk;
+        }
+        case NeighborsQ: {
+            string node = in.str();
+            if(!in.ok) {
+                return fail(out, bodyStart, "Malformed request.");
+            }
+            std::shared_lock<std::shared_mutex> guard(graphLock);
+            auto n = labels.find(node);
+            if(n == labels.end()) {
+                return fail(out, bodyStart, "No node labeled \"" + node + "\".");
+            }
+            EdgeList &edges = n->second->edges;
+            out.u32(edges.size());
+            for(int i = 0; i < edges.size(); i++) {
+                out.str(edges[i]->from(n->second)->label);
+            }
+            return QueryOk;
+        }
+        case SetTraitQ: {
+            string node = in.str();
+            string trait = in.str();
+            uint8_t type = in.u8();
+            int i = 0;
+            double d = 0;
+            string s;
+            if(type == IntT) {
+                i = in.i32();
+            } else if(type == DoubleT) {
+                d = in.f64();
+            } else if(type == StringT) {
+                s = in.str();
+            } else {
+                return fail(out, bodyStart, "Unknown trait type.");
+            }
+            if(!in.ok) {
+                return fail(out, bodyStart, "Malformed request.");
+            }
+            string error = "";
+            submitWrite([&]() {
+                auto n = labels.find(node);
+                if(n == labels.end()) {
+                    error = "No node labeled \"" + node + "\".";
+                    return 1;
+                }
+                TraitFrame &traits = n->second->traits;
+                void *p;
+                TraitType existing = traits.lookup(trait, &p);
+                if(existing != NoneT && existing != type) {
+                    error = "Trait \"" + trait + "\" has a different type.";
+                } else if(type == IntT) {
+                    traits.addInt(trait, i);
+                } else if(type == DoubleT) {
+                    traits.addDouble(trait, d);
+                } else {
+                    traits.addString(trait, s);
+                }
+                return (error != "") ? 1 : 0;
+            });
+            if(error != "") {
+                return fail(out, bodyStart, error);
+            }
+            return QueryOk;
+        }
+        case StatsQ: {
+            std::shared_lock<std::shared_mutex> guard(graphLock);
+            const GraphStatistics &stats = graphStatistics();
+            out.u64(stats.nodes);
+            out.u64(stats.edges);
+            out.u64(stats.components);
+            return QueryOk;
+        }
+        case LabelsQ: {
+            uint32_t limit = in.u32();
+            std::shared_lock<std::shared_mutex> guard(graphLock);
+            size_t countAt = out.buf.size();
+            uint32_t count = 0;
+            out.u32(0);
+            for(auto i = labels.begin(); i != labels.end() && count < limit; ++i) {
+                out.str(i->first);
+                count++;
+            }
+            memcpy(&out.buf[countAt], &count, sizeof(count));
+            return QueryOk;
+        }
+        case BatchQ: {
+            uint32_t count = in.u32();
+            out.u32(count);
+            for(uint32_t i = 0; i < count && in.ok; i++) {
+                uint8_t subOp = in.u8();
+                if(subOp == BatchQ) {
+                    return fail(out, bodyStart, "Batches cannot be nested.");
+                }
+                size_t statusAt = out.buf.size();
+                out.u8(QueryOk);
+                out.buf[statusAt] = handle(subOp, in, out);
+            }
+            if(!in.ok) {
+                return fail(out, bodyStart, "Malformed request.");
+            }
+            return QueryOk;
+        }
+        default:
+            return fail(out, bodyStart, "Unknown operation.");
+    }
+}
+
+static int submitWrite(std::function<int()> change) {
+    std::packaged_task<int()> task(change);
+    std::future<int> done = task.get_future();
+    {
+        std::lock_guard<std::mutex> guard(writesLock);
+        writes.push_back(std::move(task));
+    }
+    writesReady.notify_one();
+    return done.get();
+}
+
+static void writerLoop() {
+    while(true) {
+        std::packaged_task<int()> task;
+        {
+            std::unique_lock<std::mutex> guard(writesLock);
+            writesReady.wait(guard, []() { return !writes.empty(); });
+            task = std::move(writes.front());
+            writes.pop_front();
+        }
+        std::unique_lock<std::shared_mutex> guard(graphLock);
+        task();
+    }
+}
+
+static int replaceGraph(string fileName) {
+    std::lock_guard<std::mutex> loading(loadLock);
+    std::ifstream f;
+    f.open(fileName);
+    if(f.fail()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open \"%s\".", fileName.c_str());
+        return 1;
+    }
+    //the new graph is not counted while it is read, so the statistics readers see stay those of the old graph
+    std::vector<Drawable *> fresh;
+    std::unordered_map<string, GraphNode *> freshLabels;
+    statsPause(true);
+    int positioned = readGraph(f, freshLabels, fresh, false);
+    statsPause(false);
+    f.close();
+    //either graph is deleted whole, without a statistics update per object
+    if(positioned < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to read \"%s\" -- still serving the previous graph.",
+                     fileName.c_str());
+        deleteGraph(fresh);
+        return 1;
+    }
+
+    //readers are only held up for the swap and the recount
+    submitWrite([&]() {
+        objects.swap(fresh);
+        labels.swap(freshLabels);
+        statsReset(objects);
+        SDL_Log("Serving \"%s\": %s.", fileName.c_str(), statsSummary().c_str());
+        return 0;
+    });
+    //the old graph is out of reach of every reader now
+    deleteGraph(fresh);
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "snapshot.h"
+#include "files.h"
+
+#include <algorithm>
+
+//objects formatted per chunk when saving a snapshot
+#define SNAPSHOT_CHUNK (4096)
+
+std::shared_ptr<GraphSnapshot> takeSnapshot(const std::vector<Drawable *> &graph) {
+    std::shared_ptr<GraphSnapshot> ret = std::make_shared<GraphSnapshot>();
+    //sized for the whole registry, to avoid regrowing while copying
+    ret->nodeLabels.reserve(graph.size());
+    ret->nodeTraits.reserve(graph.size());
+    ret->edgeEnds.reserve(graph.size() * 2);
+    ret->edgeTraits.reserve(graph.size());
+    GraphNode *n;
+    GraphEdge *e;
+    for(int i = 0; i < graph.size(); i++) {
+        if(graph[i]->getState() == ExpiredS) {
+            continue;
+        }
+        switch(graph[i]->kind()) {
+            case NodeK:
+                n = static_cast<GraphNode *>(graph[i]);
+                ret->nodeLabels.push_back(n->label);
+                ret->nodeTraits.push_back(n->traits);
+                break;
+            case EdgeK:
+                e = static_cast<GraphEdge *>(graph[i]);
+                //a bundle is recorded as one edge per connection, each in its own direction
+                for(int j = 0; j < e->count(); j++) {
+                    ret->edgeEnds.push_back(e->connectionFrom(j)->label);
+                    ret->edgeEnds.push_back(e->connectionTo(j)->label);
+                    ret->edgeTraits.push_back((j == 0) ? e->traits : e->rows[j - 1]);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return ret;
+}
+
+int saveSnapshot(const GraphSnapshot &snapshot, string fileName) {
+    int nodes = snapshot.nodeLabels.size();
+    int edges = snapshot.edgeTraits.size();
+    int nodeChunks = (nodes + SNAPSHOT_CHUNK - 1) / SNAPSHOT_CHUNK;
+    int edgeChunks = (edges + SNAPSHOT_CHUNK - 1) / SNAPSHOT_CHUNK;
+    const GraphSnapshot &s = snapshot;
+    return writeChunked(fileName, nodeChunks + edgeChunks, [&](int chunk, string &out) {
+        if(chunk < nodeChunks) {
+            int end = std::min(nodes, (chunk + 1) * SNAPSHOT_CHUNK);
+            for(int i = chunk * SNAPSHOT_CHUNK; i < end; i++) {
+                out += "Node\n";
+                out += s.nodeLabels[i];
+                out += '\n';
+                s.nodeTraits[i].save(out);
+                out += '\n';
+            }
+        } else {
+            chunk -= nodeChunks;
+            int end = std::min(edges, (chunk + 1) * SNAPSHOT_CHUNK);
+            for(int i = chunk * SNAPSHOT_CHUNK; i < end; i++) {
+                out += "Edge\n";
+                out += s.edgeEnds[2 * i];
+                out += '\n';
+                out += s.edgeEnds[2 * i + 1];
+                out += '\n';
+                s.edgeTraits[i].save(out);
+                out += '\n';
+            }
+        }
+    });
+}
+
+
+SnapshotSaver::SnapshotSaver() {
+    running = false;
+}
+
+SnapshotSaver::~SnapshotSaver() {
+    wait();
+}
+
+bool SnapshotSaver::busy() {
+    return running;
+}
+
+void SnapshotSaver::wait() {
+    if(worker.joinable()) {
+        worker.join();
+    }
+}
+
+bool SnapshotSaver::save(const std::vector<Drawable *> &graph, string fileName) {
+    if(running) {
+        return false;
+    }
+    //the previous worker has finished, but must still be joined before it is replaced
+    wait();
+
+    Uint32 start = SDL_GetTicks();
+    std::shared_ptr<GraphSnapshot> snapshot = takeSnapshot(graph);
+    SDL_Log("Snapshot of %d nodes and %d edges taken in %d ms.", (int)snapshot->nodeLabels.size(),
+            (int)snapshot->edgeTraits.size(), (int)(SDL_GetTicks() - start));
+
+    running = true;
+    worker = std::thread([this, snapshot, fileName]() {
+        Uint32 start = SDL_GetTicks();
+        if(!saveSnapshot(*snapshot, fileName)) {
+            SDL_Log("Saved \"%s\" in %d ms.", fileName.c_str(), (int)(SDL_GetTicks() - start));
+        }
+        running = false;
+    });
+    return true;
+}
@@ -0,0 +1,52 @@
+//defines point-in-time copies of a graph, and saving them in the background
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "graphs.h"
+
+//copy of a graph's logical contents at one moment
+//trait frames are shared with the live graph until it is edited, so taking one copies no traits
+struct GraphSnapshot {
+    std::vector<string> nodeLabels;
+    std::vector<TraitFrame> nodeTraits;
+    //labels of both ends of every edge, as consecutive pairs
+    std::vector<string> edgeEnds;
+    std::vector<TraitFrame> edgeTraits;
+};
+
+//function to take a snapshot of every live node and edge in a registry
+//cost is one label copy and one reference count per object -- no trait is duplicated
+std::shared_ptr<GraphSnapshot> takeSnapshot(const std::vector<Drawable *> &graph);
+
+//function to save a snapshot to a file, in the format loadGraph reads
+//safe to call on any thread, while the live graph continues to be edited
+//returns nonzero iff error
+int saveSnapshot(const GraphSnapshot &snapshot, string fileName);
+
+//saves snapshots on a background thread, at most one at a time
+class SnapshotSaver {
+    public:
+        SnapshotSaver();
+        //waits for any save still in progress
+        ~SnapshotSaver();
+
+        //take a snapshot of the registry and begin saving it to a file
+        //returns false, without taking a snapshot, if the previous save has not finished
+        bool save(const std::vector<Drawable *> &graph, string fileName);
+
+        //returns true while a save is in progress
+        bool busy();
+
+        //block until any save in progress has finished
+        void wait();
+
+    private:
+        std::thread worker;
+        std::atomic<bool> running;
+};
+
+#endif
@@ -0,0 +1,393 @@
+#include "stats.h"
+#include "graphs.h"
+
+#include <deque>
+#include <unordered_set>
+
+#include <stdio.h>
+
+static GraphStatistics current;
+
+//members of every connected component, by component id
+//each node records its component, and its slot in that component's list
+static std::unordered_map<int, std::vector<GraphNode *>> members;
+static int nextComponent = 0;
+
+//set by statsPause -- per thread, so changes to the counted graph on other threads are still counted
+static thread_local bool paused = false;
+
+//connections between each pair of nodes, keyed by the pair in address order
+struct PairHash {
+    size_t operator()(const std::pair<GraphNode *, GraphNode *> &p) const {
+        return std::hash<GraphNode *>()(p.first) * 31 + std::hash<GraphNode *>()(p.second);
+    }
+};
+static std::unordered_map<std::pair<GraphNode *, GraphNode *>, int, PairHash> pairs;
+
+static std::pair<GraphNode *, GraphNode *> pairKey(GraphNode *a, GraphNode *b) {
+    return (a < b) ? std::make_pair(a, b) : std::make_pair(b, a);
+}
+
+//move a node from one degree bucket to another
+static void setDegree(GraphNode *n, int degree) {
+    if(--current.degrees[n->degree] == 0) {
+        current.degrees.erase(n->degree);
+    }
+    n->degree = degree;
+    current.degrees[degree]++;
+}
+
+//take a node out of its component's list of members, dropping the component if it empties
+static void leaveComponent(GraphNode *n) {
+    std::vector<GraphNode *> &list = members[n->component];
+    list[n->componentSlot] = list.back();
+    list[n->componentSlot]->componentSlot = n->componentSlot;
+    list.pop_back();
+    if(list.empty()) {
+        members.erase(n->component);
+        current.components--;
+    }
+}
+
+static void joinComponent(GraphNode *n, int component) {
+    std::vector<GraphNode *> &list = members[component];
+    n->component = component;
+    n->componentSlot = list.size();
+    list.push_back(n);
+}
+
+void statsNodeAdded(GraphNode *n) {
+    if(paused) {
+        return;
+    }
+    current.nodes++;
+    n->degree = 0;
+    current.degrees[0]++;
+    //every new node starts out alone
+    joinComponent(n, nextComponent++);
+    current.components++;
+}
+
+void statsNodeRemoved(GraphNode *n) {
+    if(paused) {
+        return;
+    }
+    current.nodes--;
+    if(--current.degrees[n->degree] == 0) {
+        current.degrees.erase(n->degree);
+    }
+    leaveComponent(n);
+}
+
+void statsConnectionAdded(GraphNode *a, GraphNode *b) {
+    if(paused) {
+        return;
+    }
+    current.edges++;
+    if(a == b) {
+        current.selfLoops++;
+        setDegree(a, a->degree + 2);
+    } else {
+        setDegree(a, a->degree + 1);
+        setDegree(b, b->degree + 1);
+    }
+    if(++pairs[pairKey(a, b)] > 1) {
+        current.multiEdges++;
+    }
+
+    if(a->component != b->component) {
+        //merge the smaller component into the larger
+        //a node moves only into a component at least twice the size it left, so at most log(n) times
+        int from = a->component;
+        int to = b->component;
+        if(members[from].size() > members[to].size()) {
+            std::swap(from, to);
+        }
+        std::vector<GraphNode *> moving;
+        moving.swap(members[from]);
+        members.erase(from);
+        current.components--;
+        for(int i = 0; i < moving.size(); i++) {
+            joinComponent(moving[i], to);
+        }
+    }
+}
+
+//remove count connections between a and b from the counts
+//returns how many connections between them remain
+static int dropConnections(GraphNode *a, GraphNode *b, int count) {
+    current.edges -= count;
+    if(a == b) {
+        current.selfLoops -= count;
+        setDegree(a, a->degree - 2 * count);
+    } else {
+        setDegree(a, a->degree - count);
+        setDegree(b, b->degree - count);
+    }
+    auto p = pairs.find(pairKey(a, b));
+    int before = p->second;
+    int after = before - count;
+    current.multiEdges -= (before - 1) - ((after > 0) ? after - 1 : 0);
+    if(after > 0) {
+        p->second = after;
+    } else {
+        pairs.erase(p);
+    }
+    return after;
+}
+
+//one breadth-first search of splitSearch, and every node it has reached
+struct SplitSearch {
+    std::deque<GraphNode *> queue;
+    std::vector<GraphNode *> seen;
+};
+
+//find which of the given nodes, all of one component, are no longer connected
+//one search runs from each node, a step at a time in turn, over live edges between live nodes
+//searches which meet are merged, and a search which runs out has found a whole piece, which is split off
+//once a single search is left, everything it has not reached is still in the original component,
+//so the cost is bounded by the sizes of the pieces split off, rather than by the whole component
+static void splitSearch(const std::vector<GraphNode *> &starts) {
+    if(starts.size() < 2) {
+        return;
+    }
+    std::vector<SplitSearch> searches(starts.size());
+    //searches merged into another point at it, as in a union-find
+    std::vector<int> parent(starts.size());
+    //searches still running, and the position of each in that list
+    std::vector<int> active(starts.size());
+    std::vector<int> position(starts.size());
+    std::unordered_map<GraphNode *, int> owner;
+    for(int i = 0; i < starts.size(); i++) {
+        searches[i].queue.push_back(starts[i]);
+        searches[i].seen.push_back(starts[i]);
+        parent[i] = i;
+        active[i] = i;
+        position[i] = i;
+        owner[starts[i]] = i;
+    }
+    auto find = [&](int s) {
+        while(parent[s] != s) {
+            parent[s] = parent[parent[s]];
+            s = parent[s];
+        }
+        return s;
+    };
+    auto stop = [&](int s) {
+        active[position[s]] = active.back();
+        position[active.back()] = position[s];
+        active.pop_back();
+    };
+
+    int turn = 0;
+    while(active.size() > 1) {
+        if(turn >= active.size()) {
+            turn = 0;
+        }
+        int s = active[turn];
+        if(searches[s].queue.empty()) {
+            int component = nextComponent++;
+            current.components++;
+            for(int i = 0; i < searches[s].seen.size(); i++) {
+                leaveComponent(searches[s].seen[i]);
+                joinComponent(searches[s].seen[i], component);
+            }
+            stop(s);
+            continue;
+        }
+        GraphNode *n = searches[s].queue.front();
+        searches[s].queue.pop_front();
+        for(int i = 0; i < n->edges.size(); i++) {
+            GraphEdge *e = n->edges[i];
+            if(e->getState() == ExpiredS) {
+                continue;
+            }
+            GraphNode *next = e->from(n);
+            if(!next || next->getState() == ExpiredS) {
+                continue;
+            }
+            auto o = owner.find(next);
+            if(o == owner.end()) {
+                owner[next] = s;
+                searches[s].seen.push_back(next);
+                searches[s].queue.push_back(next);
+                continue;
+            }
+            int t = find(o->second);
+            if(t == s) {
+                continue;
+            }
+            //two searches met -- the smaller is folded into the larger, which carries on
+            int from = (searches[s].seen.size() < searches[t].seen.size()) ? s : t;
+            int to = (from == s) ? t : s;
+            SplitSearch &a = searches[from];
+            SplitSearch &b = searches[to];
+            b.seen.insert(b.seen.end(), a.seen.begin(), a.seen.end());
+            b.queue.insert(b.queue.end(), a.queue.begin(), a.queue.end());
+            a.seen.clear();
+            a.queue.clear();
+            parent[from] = to;
+            stop(from);
+            s = to;
+        }
+        turn++;
+    }
+}
+
+void statsEdgeRemoved(GraphNode *a, GraphNode *b, int count) {
+    if(paused) {
+        return;
+    }
+    if(a->getState() == ExpiredS || b->getState() == ExpiredS) {
+        //an expired node's connections were dropped when it was detached
+        return;
+    }
+    if(dropConnections(a, b, count) > 0 || a == b) {
+        //a self-cycle, or a pair still joined by another edge, cannot disconnect anything
+        return;
+    }
+    splitSearch({a, b});
+}
+
+void statsNodeDetached(GraphNode *n) {
+    if(paused) {
+        return;
+    }
+    //drop every connection at once, noting each neighbor left behind
+    //a self-cycle is listed twice in the node's edges, so is dropped only the first time
+    std::vector<GraphNode *> neighbors;
+    std::unordered_set<GraphNode *> listed;
+    std::unordered_set<GraphEdge *> loops;
+    for(int i = 0; i < n->edges.size(); i++) {
+        GraphEdge *e = n->edges[i];
+        if(e->getState() == ExpiredS) {
+            continue;
+        }
+        GraphNode *other = e->from(n);
+        if(other == n) {
+            if(loops.insert(e).second) {
+                dropConnections(n, n, e->count());
+            }
+            continue;
+        }
+        dropConnections(n, other, e->count());
+        if(listed.insert(other).second) {
+            neighbors.push_back(other);
+        }
+    }
+
+    //the node is left on its own until it is deleted
+    leaveComponent(n);
+    joinComponent(n, nextComponent++);
+    current.components++;
+
+    //one search over all the former neighbors, rather than one per edge cut
+    splitSearch(neighbors);
+}
+
+void statsNodesUnloaded(const std::vector<GraphNode *> &nodes) {
+    if(paused) {
+        return;
+    }
+    //drop every connection once, even when both ends are leaving, noting the neighbors left behind
+    //neighbors are grouped by component, as each search can only split one component
+    std::unordered_set<GraphEdge *> dropped;
+    std::unordered_set<GraphNode *> listed;
+    std::unordered_map<int, std::vector<GraphNode *>> neighbors;
+    for(int i = 0; i < nodes.size(); i++) {
+        GraphNode *n = nodes[i];
+        for(int j = 0; j < n->edges.size(); j++) {
+            GraphEdge *e = n->edges[j];
+            if(e->getState() == ExpiredS || !dropped.insert(e).second) {
+                continue;
+            }
+            dropConnections(e->nodes[0], e->nodes[1], e->count());
+            GraphNode *other = e->from(n);
+            if(other->getState() != ExpiredS && listed.insert(other).second) {
+                neighbors[other->component].push_back(other);
+            }
+        }
+    }
+
+    for(int i = 0; i < nodes.size(); i++) {
+        statsNodeRemoved(nodes[i]);
+    }
+    for(auto g = neighbors.begin(); g != neighbors.end(); ++g) {
+        splitSearch(g->second);
+    }
+}
+
+void statsNodeMoved(GraphNode *from, GraphNode *to) {
+    if(paused) {
+        return;
+    }
+    to->degree = from->degree;
+    to->component = from->component;
+    to->componentSlot = from->componentSlot;
+    members[to->component][to->componentSlot] = to;
+
+    //re-key every pair the old node was part of -- parallel edges share a key, so move each once
+    for(int i = 0; i < from->edges.size(); i++) {
+        GraphNode *other = from->edges[i]->from(from);
+        auto p = pairs.find(pairKey(from, other));
+        if(p == pairs.end()) {
+            continue;
+        }
+        int count = p->second;
+        pairs.erase(p);
+        pairs[pairKey(to, (other == from) ? to : other)] = count;
+    }
+}
+
+void statsPause(bool pause) {
+    paused = pause;
+}
+
+void statsReset(const std::vector<Drawable *> &graph) {
+    current = GraphStatistics();
+    members.clear();
+    pairs.clear();
+    //counted afresh through the usual hooks -- linear, aside from merging components smaller into larger
+    for(int i = 0; i < graph.size(); i++) {
+        if(graph[i]->kind() == NodeK && graph[i]->getState() != ExpiredS) {
+            statsNodeAdded(static_cast<GraphNode *>(graph[i]));
+        }
+    }
+    for(int i = 0; i < graph.size(); i++) {
+        if(graph[i]->kind() == EdgeK && graph[i]->getState() != ExpiredS) {
+            GraphEdge *e = static_cast<GraphEdge *>(graph[i]);
+            for(int j = 0; j < e->count(); j++) {
+                statsConnectionAdded(e->nodes[0], e->nodes[1]);
+            }
+        }
+    }
+}
+
+const GraphStatistics &graphStatistics() {
+    return current;
+}
+
+bool statsConnected(GraphNode *a, GraphNode *b) {
+    return a->component == b->component;
+}
+
+std::string statsReport() {
+    char line[128];
+    std::string ret;
+    snprintf(line, sizeof(line), "Nodes: %lld\nEdges: %lld\nSelf-cycles: %lld\nParallel edges: %lld\n"
+             "Connected components: %lld\nDegree histogram:\n",
+             current.nodes, current.edges, current.selfLoops, current.multiEdges, current.components);
+    ret += line;
+    for(auto i = current.degrees.begin(); i != current.degrees.end(); ++i) {
+        snprintf(line, sizeof(line), "    %6d: %lld\n", i->first, i->second);
+        ret += line;
+    }
+    return ret;
+}
+
+std::string statsSummary() {
+    char line[128];
+    snprintf(line, sizeof(line), "%lld nodes, %lld edges, %lld components",
+             current.nodes, current.edges, current.components);
+    return line;
+}
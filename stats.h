@@ -0,0 +1,66 @@
+//defines statistics of the graph which are kept current as it is edited
+#ifndef STATS_H
+#define STATS_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+class Drawable;
+class GraphNode;
+
+//summary of the live graph
+//edges counts connections -- a bundled edge counts once per row
+//degrees count connections at a node, with a self-cycle counting twice
+struct GraphStatistics {
+    long long nodes;
+    long long edges;
+    long long selfLoops;
+    //connections beyond the first between any pair of nodes
+    long long multiEdges;
+    long long components;
+    //number of nodes having each degree
+    std::map<int, long long> degrees;
+};
+
+//mutation hooks, called by the graph classes as they change
+void statsNodeAdded(GraphNode *n);
+void statsNodeRemoved(GraphNode *n);
+void statsConnectionAdded(GraphNode *a, GraphNode *b);
+//an edge standing for count connections between a and b was cut
+//must be called once the edge is marked as expired
+void statsEdgeRemoved(GraphNode *a, GraphNode *b, int count);
+//a node marked as expired is leaving the graph, along with every edge it still has
+//its connections are dropped and its component is split in one step, so cutting its edges afterwards changes nothing
+//must be called once the node is marked as expired, before its edges are cut
+void statsNodeDetached(GraphNode *n);
+//nodes marked as expired are leaving the graph together, along with every edge they still have
+//they are taken out of every count as though deleted, so they must later be deleted without statsNodeRemoved
+//the pieces left behind are found with one search per component touched, rather than one per node
+//must be called once every node is marked as expired, before any of their edges are cut
+void statsNodesUnloaded(const std::vector<GraphNode *> &nodes);
+//a node was relocated to new storage, taking over every connection of the old one
+//must be called while the old node's edges still point at it
+void statsNodeMoved(GraphNode *from, GraphNode *to);
+
+//stop or resume counting graph objects created or deleted on the calling thread
+//used to build or delete a graph off to the side of the one counted, which statsReset counts once it takes over
+void statsPause(bool paused);
+
+//start the statistics over, counting only the live objects of the given graph
+//used after deleteGraph, whose objects are deleted without telling the statistics
+void statsReset(const std::vector<Drawable *> &graph);
+
+//returns the current statistics
+const GraphStatistics &graphStatistics();
+
+//returns true iff two live nodes are connected by some path
+bool statsConnected(GraphNode *a, GraphNode *b);
+
+//returns a multi-line description of every statistic, including the degree histogram
+std::string statsReport();
+
+//returns a single line with the main counts, short enough for a window title
+std::string statsSummary();
+
+#endif
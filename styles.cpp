@@ -0,0 +1,279 @@
+#include "styles.h"
+#include "graphs.h"
+
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include <math.h>
+#include <stdio.h>
+
+//objects styled per thread before it is worth starting more threads
+#define STYLE_CHUNK (65536)
+
+//identifiers for the part of a style a rule sets
+enum StyleProperty {
+    SizeP,
+    ColorP
+};
+
+struct StyleRule {
+    DrawableKind target;
+    StyleProperty property;
+    string trait;
+    //range of trait values mapped onto the property, if given
+    bool ranged;
+    double low, high;
+};
+
+static std::vector<StyleRule> rules;
+
+//incremented whenever the rules change, making every cached style stale
+//starts at one, so styles which were never computed are stale too
+static unsigned generation = 1;
+
+//values seen so far by each categorical color rule, numbered in the order they were first seen
+//indexed like rules -- other rules have an empty table
+//the lock is for applyStyles' worker threads, which look values up together
+//every value in the graph is numbered before they start, so they normally only read
+//a value first seen later, e.g. while drawing an edited object, is added under the lock alone
+static std::vector<std::unordered_map<string, int>> categories;
+static std::shared_mutex categoryLock;
+
+//first colors for categories -- distinct from each other and from the background
+static const float palette[8][3] = {
+    {0.12f, 0.47f, 0.71f},
+    {1.00f, 0.50f, 0.05f},
+    {0.17f, 0.63f, 0.17f},
+    {0.84f, 0.15f, 0.16f},
+    {0.58f, 0.40f, 0.74f},
+    {0.55f, 0.34f, 0.29f},
+    {0.89f, 0.47f, 0.76f},
+    {0.20f, 0.20f, 0.20f}
+};
+
+int loadStyles(string fileName) {
+    std::ifstream f;
+    f.open(fileName);
+    if(f.fail()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "loadStyles failed to open file.");
+        return 1;
+    }
+
+    std::vector<StyleRule> read;
+    string line;
+    int lineNumber = 0;
+    while(std::getline(f, line)) {
+        lineNumber++;
+        std::istringstream words(line);
+        string target, property;
+        StyleRule rule;
+        if(!(words >> target) || target[0] == '#') {
+            continue;
+        }
+        if(!(words >> property >> rule.trait)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Style line %d is incomplete.", lineNumber);
+            return 1;
+        }
+        rule.ranged = (bool)(words >> rule.low >> rule.high);
+
+        if(target == "Node") {
+            rule.target = NodeK;
+        } else if(target == "Edge") {
+            rule.target = EdgeK;
+        } else {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Style line %d: unknown target \"%s\".",
+                         lineNumber, target.c_str());
+            return 1;
+        }
+        if((property == "Size" && rule.target == NodeK) || (property == "Width" && rule.target == EdgeK)) {
+            rule.property = SizeP;
+            if(!rule.ranged) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Style line %d: %s needs a range.",
+                             lineNumber, property.c_str());
+                return 1;
+            }
+        } else if(property == "Color") {
+            rule.property = ColorP;
+        } else {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Style line %d: unknown property \"%s\" for %s.",
+                         lineNumber, property.c_str(), target.c_str());
+            return 1;
+        }
+        if(rule.ranged && rule.high == rule.low) {
+            rule.high = rule.low + 1;
+        }
+        read.push_back(rule);
+    }
+    f.close();
+
+    rules = read;
+    categories.assign(rules.size(), std::unordered_map<string, int>());
+    generation++;
+    SDL_Log("Loaded %d style rules.", (int)rules.size());
+    return 0;
+}
+
+//read a trait as a number, returns false if it is missing or a string
+static bool numeric(const TraitFrame &traits, const string &label, double *v) {
+    const void *p;
+    TraitType t = traits.get(label, &p);
+    if(t == IntT) {
+        *v = *(const int *)p;
+        return true;
+    } else if(t == DoubleT) {
+        *v = *(const double *)p;
+        return true;
+    }
+    return false;
+}
+
+//color of the i-th category -- the palette, then hues spread by the golden ratio, so no two categories share one
+static void categoryColor(int i, float *color) {
+    if(i < 8) {
+        std::copy(palette[i], palette[i] + 3, color);
+        return;
+    }
+    double hue = fmod((i - 8) * 0.618033988749895, 1.0) * 6;
+    //alternate shades, so neighboring hues are told apart by brightness as well
+    double value = (i % 2) ? 0.65 : 0.9;
+    double saturation = 0.7;
+    double f = hue - floor(hue);
+    double p = value * (1 - saturation);
+    double q = value * (1 - saturation * f);
+    double t = value * (1 - saturation * (1 - f));
+    double rgb[6][3] = {{value, t, p}, {q, value, p}, {p, value, t}, {p, q, value}, {t, p, value}, {value, p, q}};
+    for(int c = 0; c < 3; c++) {
+        color[c] = rgb[(int)hue % 6][c];
+    }
+}
+
+//number a categorical rule's value, giving it the next number if it is new
+//returns -1 if the trait is missing
+static int category(int ruleIndex, const TraitFrame &traits) {
+    const void *p;
+    string key;
+    char number[32];
+    switch(traits.get(rules[ruleIndex].trait, &p)) {
+        case IntT:
+            snprintf(number, sizeof(number), "i%d", *(const int *)p);
+            key = number;
+            break;
+        case DoubleT:
+            snprintf(number, sizeof(number), "d%.17g", *(const double *)p);
+            key = number;
+            break;
+        case StringT:
+            key = "s" + *(const string *)p;
+            break;
+        default:
+            return -1;
+    }
+    std::unordered_map<string, int> &table = categories[ruleIndex];
+    {
+        std::shared_lock<std::shared_mutex> guard(categoryLock);
+        auto c = table.find(key);
+        if(c != table.end()) {
+            return c->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> guard(categoryLock);
+    auto c = table.insert(std::make_pair(key, (int)table.size()));
+    return c.first->second;
+}
+
+static void computeStyle(Style &style, const TraitFrame &traits, DrawableKind kind) {
+    Style fresh;
+    for(int i = 0; i < rules.size(); i++) {
+        const StyleRule &rule = rules[i];
+        if(rule.target != kind) {
+            continue;
+        }
+        if(rule.property == ColorP && !rule.ranged) {
+            //categorical -- any value type, each distinct value with its own color
+            int c = category(i, traits);
+            if(c >= 0) {
+                categoryColor(c, fresh.color);
+            }
+            continue;
+        }
+
+        double v;
+        if(!numeric(traits, rule.trait, &v)) {
+            continue;
+        }
+        double t = std::min(1.0, std::max(0.0, (v - rule.low) / (rule.high - rule.low)));
+        if(rule.property == ColorP) {
+            fresh.color[0] = t;
+            fresh.color[1] = 0.2;
+            fresh.color[2] = 1 - t;
+        } else if(kind == NodeK) {
+            //radius from half to three times the unstyled size
+            fresh.size = 0.5 + 2.5 * t;
+        } else {
+            //line width from one to eight pixels
+            fresh.size = 1 + 7 * t;
+        }
+    }
+    fresh.generation = generation;
+    fresh.version = traits.version();
+    style = fresh;
+}
+
+void refreshStyle(Style &style, const TraitFrame &traits, DrawableKind kind) {
+    if(style.generation != generation || style.version != traits.version()) {
+        computeStyle(style, traits, kind);
+    }
+}
+
+void applyStyles(const std::vector<Drawable *> &graph) {
+    //categories are numbered in registry order first, so colors do not depend on how threads interleave
+    for(int r = 0; r < rules.size(); r++) {
+        if(rules[r].property != ColorP || rules[r].ranged) {
+            continue;
+        }
+        for(int i = 0; i < graph.size(); i++) {
+            if(graph[i]->kind() == NodeK && rules[r].target == NodeK) {
+                category(r, static_cast<GraphNode *>(graph[i])->traits);
+            } else if(graph[i]->kind() == EdgeK && rules[r].target == EdgeK) {
+                category(r, static_cast<GraphEdge *>(graph[i])->traits);
+            }
+        }
+    }
+
+    auto work = [&](int start, int end) {
+        for(int i = start; i < end; i++) {
+            switch(graph[i]->kind()) {
+                case NodeK: {
+                    GraphNode *n = static_cast<GraphNode *>(graph[i]);
+                    refreshStyle(n->style, n->traits, NodeK);
+                    break;
+                }
+                case EdgeK: {
+                    GraphEdge *e = static_cast<GraphEdge *>(graph[i]);
+                    refreshStyle(e->style, e->traits, EdgeK);
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    };
+
+    int threadCount = std::min((int)std::thread::hardware_concurrency(), (int)(graph.size() / STYLE_CHUNK));
+    if(threadCount < 2) {
+        work(0, graph.size());
+        return;
+    }
+    std::vector<std::thread> threads;
+    int step = (graph.size() + threadCount - 1) / threadCount;
+    for(int i = 0; i < threadCount; i++) {
+        threads.push_back(std::thread(work, i * step, std::min((int)graph.size(), (i + 1) * step)));
+    }
+    for(int i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
@@ -0,0 +1,30 @@
+//defines rules which map traits onto the appearance of nodes and edges
+#ifndef STYLES_H
+#define STYLES_H
+
+#include <string>
+#include <vector>
+
+#include "drawing.h"
+
+class TraitFrame;
+
+//function to read style rules from a file, replacing any current rules
+//each line is one rule: <Node|Edge> <Size|Width|Color> <trait label> [low high]
+//  Size (nodes) and Width (edges) map a numeric trait from [low, high] onto a range of sizes
+//  Color with a range maps a numeric trait onto a blue-to-red gradient
+//  Color without a range gives each distinct value of a trait its own color, in the order values are first seen
+//a bundled edge is styled from the traits of its first connection only -- its other rows are not read
+//trait labels cannot contain spaces here. lines beginning with '#' are comments
+//later rules override earlier rules for the same property
+//returns nonzero iff error, in which case the current rules are kept
+int loadStyles(std::string fileName);
+
+//function to bring a cached style up to date, if the rules or the traits changed since it was computed
+//costs two comparisons when nothing changed, so drawing can call it every frame
+void refreshStyle(Style &style, const TraitFrame &traits, DrawableKind kind);
+
+//function to refresh the style of every node and edge in a registry at once, on several threads
+void applyStyles(const std::vector<Drawable *> &graph);
+
+#endif
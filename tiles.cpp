@@ -0,0 +1,507 @@
+#include "tiles.h"
+#include "files.h"
+#include "memory.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <math.h>
+#include <stdio.h>
+
+//bytes buffered across every tile, while streaming a graph file, before the buffers are appended to their files
+#define TILE_FLUSH (16 << 20)
+
+//pack a pair of tile coordinates into a single key
+static long long tileKey(int tx, int ty) {
+    return ((long long)tx << 32) | (unsigned int)ty;
+}
+
+static int tileX(long long key) {
+    return (int)(key >> 32);
+}
+
+static int tileY(long long key) {
+    return (int)(key & 0xFFFFFFFF);
+}
+
+static string tileFile(string dirName, long long key) {
+    return dirName + "/tile_" + std::to_string(tileX(key)) + "_" + std::to_string(tileY(key)) + ".txt";
+}
+
+static int tileCoord(double v, double tileSize) {
+    return (int)floor(v / tileSize);
+}
+
+int buildTiles(std::vector<Drawable *> graph, string dirName, double tileSize) {
+    std::unordered_map<long long, std::vector<GraphNode *>> tileNodes;
+    std::unordered_map<long long, std::vector<GraphEdge *>> tileEdges;
+    std::unordered_map<GraphNode *, long long> keys;
+
+    GraphNode *n;
+    GraphEdge *e;
+    for(int i = 0; i < graph.size(); i++) {
+        if(graph[i]->kind() == NodeK && graph[i]->getState() != ExpiredS) {
+            n = static_cast<GraphNode *>(graph[i]);
+            long long key = tileKey(tileCoord(n->x, tileSize), tileCoord(n->y, tileSize));
+            tileNodes[key].push_back(n);
+            keys[n] = key;
+        }
+    }
+    for(int i = 0; i < graph.size(); i++) {
+        if(graph[i]->kind() != EdgeK || graph[i]->getState() == ExpiredS) {
+            continue;
+        }
+        e = static_cast<GraphEdge *>(graph[i]);
+        if(e->nodes[0] && e->nodes[1]) {
+            long long k0 = keys[e->nodes[0]];
+            long long k1 = keys[e->nodes[1]];
+            tileEdges[k0].push_back(e);
+            if(k1 != k0) {
+                tileEdges[k1].push_back(e);
+            }
+        }
+    }
+
+    std::error_code err;
+    std::filesystem::create_directories(dirName, err);
+    if(err) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "buildTiles failed to create directory: %s",
+                     err.message().c_str());
+        return 1;
+    }
+
+    std::ofstream index;
+    index.open(dirName + "/index.txt");
+    if(index.fail()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "buildTiles failed to open index file.");
+        return 1;
+    }
+    //index follows the three-line style of graph files
+    index << "TileSize\n" << tileSize << "\n\n";
+
+    std::ofstream f;
+    for(auto t = tileNodes.begin(); t != tileNodes.end(); ++t) {
+        f.open(tileFile(dirName, t->first));
+        if(f.fail()) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "buildTiles failed to open a tile file.");
+            return 1;
+        }
+        //positions must round-trip exactly, or nodes near a border would change tiles
+        f.precision(17);
+        for(int i = 0; i < t->second.size(); i++) {
+            n = t->second[i];
+            f << "Node\n" << n->label << "\n";
+            n->traits.save(f);
+            f << "Position\n" << n->x << "\n" << n->y << "\n\n";
+        }
+        std::vector<GraphEdge *> &edges = tileEdges[t->first];
+        string buf;
+        for(int i = 0; i < edges.size(); i++) {
+            edges[i]->save(buf);
+        }
+        f << buf;
+        f.close();
+
+        index << "Tile\n" << tileX(t->first) << "\n" << tileY(t->first) << "\n\n";
+    }
+    index.close();
+
+    SDL_Log("Wrote %d tiles to \"%s\".", (int)tileNodes.size(), dirName.c_str());
+    return 0;
+}
+
+//read the lines of the next object in a graph file, up to the blank line ending it
+//returns false once the file has no objects left
+static bool readBlock(std::istream &f, std::vector<string> &block) {
+    block.clear();
+    string line;
+    while(std::getline(f, line)) {
+        if(line != "") {
+            block.push_back(line);
+        } else if(!block.empty()) {
+            break;
+        }
+    }
+    return !block.empty();
+}
+
+//find the position given in a node's block, if any
+//returns the line at which the position starts, or -1 if there is none
+static int blockPosition(const std::vector<string> &block) {
+    //after the label, a node's block is made of three-line entries -- traits, or its position
+    for(int i = 2; i + 2 < block.size(); i += 3) {
+        if(block[i] == "Position") {
+            return i;
+        }
+    }
+    return -1;
+}
+
+//buffers of tile file contents, appended to their files whenever they grow too large
+struct TileWriter {
+    string dirName;
+    std::unordered_map<long long, string> nodes;
+    std::unordered_map<long long, string> edges;
+    //tiles whose files have been started -- the first write truncates anything left by an earlier build
+    std::unordered_set<long long> nodesStarted;
+    std::unordered_set<long long> edgesStarted;
+    size_t buffered = 0;
+
+    //returns nonzero iff error
+    int flush() {
+        for(int pass = 0; pass < 2; pass++) {
+            std::unordered_map<long long, string> &buffers = pass ? edges : nodes;
+            std::unordered_set<long long> &started = pass ? edgesStarted : nodesStarted;
+            for(auto t = buffers.begin(); t != buffers.end(); ++t) {
+                string name = tileFile(dirName, t->first) + (pass ? ".edges" : "");
+                std::ofstream f;
+                f.open(name, started.insert(t->first).second ? std::ios::trunc : std::ios::app);
+                f << t->second;
+                f.close();
+                if(f.fail()) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "buildTiles failed to write \"%s\".", name.c_str());
+                    return 1;
+                }
+            }
+            buffers.clear();
+        }
+        buffered = 0;
+        return 0;
+    }
+
+    //returns nonzero iff error
+    int add(std::unordered_map<long long, string> &buffers, long long key, const string &text) {
+        buffers[key] += text;
+        buffered += text.size();
+        return (buffered > TILE_FLUSH) ? flush() : 0;
+    }
+};
+
+int buildTilesFromFile(string graphFile, string dirName, double tileSize) {
+    std::ifstream f;
+    f.open(graphFile);
+    if(f.fail()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "buildTiles failed to open \"%s\".", graphFile.c_str());
+        return 1;
+    }
+    //the first pass counts the nodes without a position, which the circle layout is spread over
+    std::vector<string> block;
+    int unplacedCount = 0;
+    while(readBlock(f, block)) {
+        if(block[0] == "Node" && blockPosition(block) < 0) {
+            unplacedCount++;
+        }
+    }
+    f.clear();
+    f.seekg(0);
+
+    std::error_code err;
+    std::filesystem::create_directories(dirName, err);
+    if(err) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "buildTiles failed to create directory: %s",
+                     err.message().c_str());
+        return 1;
+    }
+
+    //the tile of every node read so far, by label -- the only part of the graph kept in memory
+    std::unordered_map<string, long long> keys;
+    TileWriter writer;
+    writer.dirName = dirName;
+    int unplaced = 0;
+    while(readBlock(f, block)) {
+        if(block[0] == "Node" && block.size() >= 2 && block.size() % 3 == 2) {
+            if(keys.count(block[1])) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Duplicate node label: \"%s\"", block[1].c_str());
+                return 1;
+            }
+            double x;
+            double y;
+            int at = blockPosition(block);
+            if(at >= 0) {
+                x = stod(block[at + 1]);
+                y = stod(block[at + 2]);
+            } else {
+                circlePosition(unplaced++, unplacedCount, &x, &y);
+            }
+            long long key = tileKey(tileCoord(x, tileSize), tileCoord(y, tileSize));
+            keys[block[1]] = key;
+
+            string text = "Node\n" + block[1] + "\n";
+            for(int i = 2; i < block.size(); i += 3) {
+                if(i != at) {
+                    text += block[i] + "\n" + block[i + 1] + "\n" + block[i + 2] + "\n";
+                }
+            }
+            //positions must round-trip exactly, or nodes near a border would change tiles
+            char position[80];
+            snprintf(position, sizeof(position), "Position\n%.17g\n%.17g\n\n", x, y);
+            text += position;
+            if(writer.add(writer.nodes, key, text)) {
+                return 1;
+            }
+        } else if(block[0] == "Edge" && block.size() >= 3 && block.size() % 3 == 0) {
+            auto k0 = keys.find(block[1]);
+            auto k1 = keys.find(block[2]);
+            if(k0 == keys.end() || k1 == keys.end()) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unrecognized node label: \"%s\"",
+                             ((k0 == keys.end()) ? block[1] : block[2]).c_str());
+                return 1;
+            }
+            string text;
+            for(int i = 0; i < block.size(); i++) {
+                text += block[i] + "\n";
+            }
+            text += "\n";
+            //edges between two tiles are written into both
+            if(writer.add(writer.edges, k0->second, text) ||
+               (k1->second != k0->second && writer.add(writer.edges, k1->second, text))) {
+                return 1;
+            }
+        } else {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "buildTiles found a malformed object starting \"%s\".",
+                         block[0].c_str());
+            return 1;
+        }
+    }
+    f.close();
+    if(writer.flush()) {
+        return 1;
+    }
+
+    //edges were kept apart while streaming, so every tile file lists its nodes before any edge needs them
+    std::ofstream index;
+    index.open(dirName + "/index.txt");
+    if(index.fail()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "buildTiles failed to open index file.");
+        return 1;
+    }
+    index << "TileSize\n" << tileSize << "\n\n";
+    for(auto t = writer.nodesStarted.begin(); t != writer.nodesStarted.end(); ++t) {
+        if(writer.edgesStarted.count(*t)) {
+            string edgeName = tileFile(dirName, *t) + ".edges";
+            std::ifstream in(edgeName);
+            std::ofstream out(tileFile(dirName, *t), std::ios::app);
+            out << in.rdbuf();
+            in.close();
+            out.close();
+            std::filesystem::remove(edgeName, err);
+        }
+        index << "Tile\n" << tileX(*t) << "\n" << tileY(*t) << "\n\n";
+    }
+    index.close();
+
+    SDL_Log("Wrote %d tiles to \"%s\".", (int)writer.nodesStarted.size(), dirName.c_str());
+    return 0;
+}
+
+
+TileCache::TileCache() {
+    tileSize = 0;
+    budget = 0;
+    residentBytes = 0;
+}
+
+bool TileCache::isOpen() {
+    return tileSize > 0;
+}
+
+int TileCache::open(string dirName, long long inBudget) {
+    std::ifstream f;
+    f.open(dirName + "/index.txt");
+    if(f.fail()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "TileCache failed to open index of \"%s\".",
+                     dirName.c_str());
+        return 1;
+    }
+
+    string lines[3] = {""};
+    while(std::getline(f, lines[0])) {
+        if(lines[0] == "") {
+            continue;
+        }
+        if(!(std::getline(f, lines[1]) && std::getline(f, lines[2]))) {
+            break;
+        }
+        if(lines[0] == "TileSize") {
+            tileSize = stod(lines[1]);
+        } else if(lines[0] == "Tile") {
+            present.insert(tileKey(stoi(lines[1]), stoi(lines[2])));
+        }
+    }
+    f.close();
+
+    if(tileSize <= 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Tile index of \"%s\" has no tile size.",
+                     dirName.c_str());
+        return 1;
+    }
+    dir = dirName;
+    budget = inBudget;
+    SDL_Log("Opened %d tiles of size %lf.", (int)present.size(), tileSize);
+    return 0;
+}
+
+void TileCache::update(double minX, double minY, double maxX, double maxY,
+                       double dx, double dy, std::vector<Drawable *> &registry) {
+    if(!isOpen()) {
+        return;
+    }
+    std::unordered_set<long long> needed;
+    std::unordered_set<long long> prefetched;
+
+    int tx0 = tileCoord(minX, tileSize);
+    int ty0 = tileCoord(minY, tileSize);
+    int tx1 = tileCoord(maxX, tileSize);
+    int ty1 = tileCoord(maxY, tileSize);
+    touchRange(tx0, ty0, tx1, ty1, needed, registry);
+
+    //prefetch the band of tiles just past the view, in the direction of panning
+    int px = (dx > 0) - (dx < 0);
+    int py = (dy > 0) - (dy < 0);
+    if(px) {
+        int col = (px > 0) ? tx1 + 1 : tx0 - 1;
+        touchRange(col, ty0, col, ty1, prefetched, registry);
+    }
+    if(py) {
+        int row = (py > 0) ? ty1 + 1 : ty0 - 1;
+        touchRange(tx0, row, tx1, row, prefetched, registry);
+    }
+
+    //the visible tiles were touched first, so they sit behind the prefetched ones in the list
+    //evicting from the back could still hit them when the budget is smaller than the view
+    long long neededBytes = 0;
+    for(auto k = needed.begin(); k != needed.end(); ++k) {
+        auto r = residentIndex.find(*k);
+        if(r != residentIndex.end()) {
+            neededBytes += r->second->bytes;
+        }
+    }
+    if(neededBytes > budget) {
+        SDL_Log("Visible tiles (%lld bytes) exceed the tile budget (%lld bytes).", neededBytes, budget);
+    }
+    auto t = resident.end();
+    while(residentBytes > budget && t != resident.begin()) {
+        --t;
+        if(needed.count(t->key)) {
+            continue;
+        }
+        auto victim = t;
+        ++t;
+        evict(victim);
+    }
+}
+
+void TileCache::touchRange(int tx0, int ty0, int tx1, int ty1,
+                           std::unordered_set<long long> &keep, std::vector<Drawable *> &registry) {
+    //when zoomed far out, walking the index is cheaper than walking the range
+    long long area = (long long)(tx1 - tx0 + 1) * (ty1 - ty0 + 1);
+    std::vector<long long> keys;
+    if(area > (long long)present.size()) {
+        for(auto i = present.begin(); i != present.end(); ++i) {
+            int tx = tileX(*i);
+            int ty = tileY(*i);
+            if(tx >= tx0 && tx <= tx1 && ty >= ty0 && ty <= ty1) {
+                keys.push_back(*i);
+            }
+        }
+    } else {
+        for(int tx = tx0; tx <= tx1; tx++) {
+            for(int ty = ty0; ty <= ty1; ty++) {
+                if(present.count(tileKey(tx, ty))) {
+                    keys.push_back(tileKey(tx, ty));
+                }
+            }
+        }
+    }
+
+    for(int i = 0; i < keys.size(); i++) {
+        auto r = residentIndex.find(keys[i]);
+        if(r == residentIndex.end()) {
+            load(keys[i], registry);
+        } else {
+            //refresh position in the least-recently-used order
+            resident.splice(resident.begin(), resident, r->second);
+        }
+        keep.insert(keys[i]);
+    }
+}
+
+void TileCache::load(long long key, std::vector<Drawable *> &registry) {
+    std::ifstream f;
+    f.open(tileFile(dir, key));
+    if(f.fail()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "TileCache failed to open tile %d, %d -- it is left out.",
+                     tileX(key), tileY(key));
+        present.erase(key);
+        return;
+    }
+
+    //edges to tiles not resident are skipped -- they are read again when the other tile is loaded
+    //edges joining an already resident tile are counted with this one, as they were allocated for it
+    int first = registry.size();
+    long long before = memoryTotal().bytes.load(std::memory_order_relaxed);
+    int read = readGraph(f, nodes, registry, true);
+    f.close();
+
+    resident.push_front(Tile());
+    resident.front().key = key;
+    resident.front().bytes = std::max(0LL, memoryTotal().bytes.load(std::memory_order_relaxed) - before);
+    residentBytes += resident.front().bytes;
+    residentIndex[key] = resident.begin();
+    GraphNode *n;
+    for(int i = first; i < registry.size(); i++) {
+        if(registry[i]->kind() == NodeK) {
+            n = static_cast<GraphNode *>(registry[i]);
+            resident.front().nodes.push_back(n);
+            owners[n] = key;
+        }
+    }
+
+    if(read < 0) {
+        //whatever was read before the error is paged out again, and the tile is not tried again
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "TileCache failed to read tile %d, %d -- it is left out.",
+                     tileX(key), tileY(key));
+        present.erase(key);
+        evict(resident.begin());
+    }
+}
+
+void TileCache::release(Drawable *d) {
+    if(d->kind() != NodeK) {
+        return;
+    }
+    GraphNode *n = static_cast<GraphNode *>(d);
+    auto o = owners.find(n);
+    if(o == owners.end()) {
+        //created by the user, or already evicted
+        return;
+    }
+    std::vector<GraphNode *> &tileNodes = residentIndex[o->second]->nodes;
+    for(int i = 0; i < tileNodes.size(); i++) {
+        if(tileNodes[i] == n) {
+            tileNodes[i] = tileNodes.back();
+            tileNodes.pop_back();
+            break;
+        }
+    }
+    nodes.erase(n->label);
+    owners.erase(o);
+}
+
+void TileCache::evict(std::list<Tile>::iterator t) {
+    //a node deleted by the user while resident has already cut its edges, and is deleted as usual
+    std::vector<GraphNode *> leaving;
+    GraphNode *n;
+    for(int i = 0; i < t->nodes.size(); i++) {
+        n = t->nodes[i];
+        if(n->getState() != ExpiredS) {
+            leaving.push_back(n);
+        }
+        nodes.erase(n->label);
+        owners.erase(n);
+    }
+    //paging out is not an edit -- the tile is dropped quietly, with one update to the statistics
+    unloadNodes(leaving);
+    residentBytes -= t->bytes;
+    residentIndex.erase(t->key);
+    resident.erase(t);
+}
@@ -0,0 +1,88 @@
+//defines a spatially tiled on-disk layout for graphs, and a cache which pages it in and out
+#ifndef TILES_H
+#define TILES_H
+
+#include <list>
+#include <unordered_set>
+
+#include "graphs.h"
+
+//function to split a graph into square world-space tiles of side tileSize, written into dirName
+//each tile file holds the nodes positioned inside it, then every edge touching one of those nodes
+//edges between two tiles are therefore written into both
+//returns nonzero iff error
+int buildTiles(std::vector<Drawable *> graph, string dirName, double tileSize);
+
+//function to split a graph file into tiles, as buildTiles does, without reading the graph into memory
+//the file is streamed twice -- once to count nodes without a position, once to write the tiles
+//only each node's label and tile are held in memory, and nodes without a position are laid out as loadGraph would
+//returns nonzero iff error
+int buildTilesFromFile(string graphFile, string dirName, double tileSize);
+
+//a tile currently paged into memory
+struct Tile {
+    long long key;
+    std::vector<GraphNode *> nodes;
+    //tracked memory allocated while reading the tile in
+    long long bytes;
+};
+
+//cache of resident tiles from a graph written by buildTiles
+//tiles are paged in as the camera reaches them, and the least recently used are paged out
+//once the resident tiles take more memory than the budget
+//paged-out tiles are not written back -- edits to them are lost
+class TileCache {
+    public:
+        TileCache();
+
+        //open a tiled graph directory, keeping at most budget bytes of tiles resident
+        //returns nonzero iff error
+        int open(string dirName, long long budget);
+
+        //returns true iff a tiled graph is open
+        bool isOpen();
+
+        //page in every tile overlapping the given world-space rectangle
+        //(dx, dy) is the latest camera motion -- the next tiles in that direction are prefetched
+        //new drawables are appended to registry
+        //evicted drawables are marked as expired, for the registry owner to delete
+        void update(double minX, double minY, double maxX, double maxY,
+                    double dx, double dy, std::vector<Drawable *> &registry);
+
+        //forget a drawable which the registry owner is about to delete
+        //must be called for every deleted drawable while a tiled graph is open
+        void release(Drawable *d);
+
+    private:
+        //read a single tile from disk, and move it to the front of the resident list
+        void load(long long key, std::vector<Drawable *> &registry);
+        //mark a tile's nodes, and every edge touching them, as expired
+        //they are unloaded together, so deleting them is neither logged nor counted object by object
+        void evict(std::list<Tile>::iterator t);
+
+        //load, or refresh, every indexed tile within a range of tile coordinates
+        //keys touched are added to keep
+        void touchRange(int tx0, int ty0, int tx1, int ty1,
+                        std::unordered_set<long long> &keep, std::vector<Drawable *> &registry);
+
+        string dir;
+        double tileSize;
+        long long budget;
+        //memory taken by every resident tile together
+        long long residentBytes;
+
+        //every tile which exists on disk
+        std::unordered_set<long long> present;
+
+        //resident tiles, most recently used at the front
+        std::list<Tile> resident;
+        std::unordered_map<long long, std::list<Tile>::iterator> residentIndex;
+
+        //every resident node, by label -- used to join edges between tiles
+        std::unordered_map<string, GraphNode *> nodes;
+
+        //tile each resident node was paged in from
+        std::unordered_map<GraphNode *, long long> owners;
+};
+
+#endif